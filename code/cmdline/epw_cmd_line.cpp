@@ -307,20 +307,19 @@ int main(int argc, char *argv[])
 		return 0;
 	}
 
-	epw::sim::LookupTables::flags_t flags;
-	flags.set(epw::sim::LookupTables::OMAHA_HANDS);
-	flags.set(epw::sim::LookupTables::OMAHA_HAND_VALS);
-	flags.set(epw::sim::LookupTables::THREE_RANK_COMBOS);
-	if(!epw::sim::LookupTables::initialize(flags))
-	{
-		epw::cout << _T("Failed to initialize lookup tables") << std::endl;
-		return 0;
-	}
-
 	for(epw::sim::Scenario const& scenario: scenarios)
 	{
 		for(size_t idx = 0; idx < scenario.sims.size(); ++idx)
 		{
+			// Only the tables this sim reads are built, each the first time any sim needs it
+			epw::sim::LookupTables::flags_t flags = epw::sim::required_lookup_tables(scenario, idx);
+			flags.set(epw::sim::LookupTables::MAPPED_TABLES);
+			if(!epw::sim::LookupTables::initialize(flags))
+			{
+				epw::cout << _T("Failed to initialize lookup tables") << std::endl;
+				return 0;
+			}
+
 			epw::sim::generic_sim_results_t results;
 			bool run_ok = epw::sim::run_simulation(scenario, idx, results);
 			if(!run_ok)
@@ -0,0 +1,61 @@
+// epw_lookup_tables.cpp
+/*! Command line tool to generate the precomputed lookup tables into a blob file, which sims then memory map at startup */
+
+#include "gen_util/epw_string.hpp"
+
+#include "simulation/lookup_tables.hpp"
+
+#include <chrono>
+
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		epw::cout <<
+			_T("epw_lookup_tables usage\n")
+			_T("epw_lookup_tables <output file>\n")
+			_T("Generates the lookup tables and writes them to a blob file. Sims map the blob named by the EPW_LOOKUP_TABLES ")
+			_T("environment variable, or lookup_tables.bin, if it was written by the same build.\n")
+			_T("e.g. epw_lookup_tables lookup_tables.bin\n");
+		return 1;
+	}
+
+	epw::string const filename = epw::narrow_to_epw(argv[1]);
+
+	std::chrono::system_clock::time_point commenced = std::chrono::system_clock::now();
+
+	// Deliberately not MAPPED_TABLES, so that the tables are generated afresh
+	epw::sim::LookupTables::flags_t flags;
+	flags.set(epw::sim::LookupTables::OMAHA_HANDS);
+	flags.set(epw::sim::LookupTables::OMAHA_HAND_VALS);
+	flags.set(epw::sim::LookupTables::THREE_RANK_COMBOS);
+	flags.set(epw::sim::LookupTables::OMAHA_EVAL);
+	flags.set(epw::sim::LookupTables::HOLDEM_EVAL);
+	flags.set(epw::sim::LookupTables::BATCH_EVAL);
+	if(!epw::sim::LookupTables::initialize(flags))
+	{
+		epw::cout << _T("Failed to initialize lookup tables") << std::endl;
+		return 1;
+	}
+
+	// The ranking depends on default_omaha_ranking.txt, so is included only if it can be loaded
+	epw::sim::LookupTables::flags_t ranking_flags;
+	ranking_flags.set(epw::sim::LookupTables::OMAHA_RANKING);
+	if(!epw::sim::LookupTables::initialize(ranking_flags))
+	{
+		epw::cout << _T("Omaha ranking not available, omitting it") << std::endl;
+	}
+
+	if(!epw::sim::LookupTables::write_blob(filename))
+	{
+		epw::cout << _T("Failed to write ") << filename << std::endl;
+		return 1;
+	}
+
+	std::chrono::duration< double, std::ratio< 1 > > const secs = std::chrono::system_clock::now() - commenced;
+
+	epw::cout << _T("Lookup tables written to ") << filename << _T(" in ") << secs.count() << _T("s") << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+// epw_matchup_store.cpp
+/*! Command line tool to precompute the exact equities of preflop Omaha matchups into a store file for use by range equity sims */
+
+#include "gen_util/epw_string.hpp"
+
+#include "poker_core/cardset.hpp"
+#include "poker_core/composite_card_match.hpp"
+
+#include "simulation/lookup_tables.hpp"
+#include "simulation/preflop_matchup_store.hpp"
+
+#include "parsing/parser_helpers.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+
+int main(int argc, char *argv[])
+{
+	if(argc < 4)
+	{
+		epw::cout <<
+			_T("epw_matchup_store usage\n")
+			_T("epw_matchup_store <output file> '<omaha range 1>' '<omaha range 2>' [<threads>]\n")
+			_T("Calculates every matchup of a hand from range 1 against a hand from range 2. Sims read the store named by the ")
+			_T("EPW_PREFLOP_MATCHUPS environment variable, or preflop_matchups.bin.\n")
+			_T("e.g. epw_matchup_store preflop_matchups.bin 'AAxx' 'KKxx'\n");
+		return 1;
+	}
+
+	epw::string const filename = epw::narrow_to_epw(argv[1]);
+	size_t const num_threads = argc > 4 ? (size_t)std::strtoul(argv[4], nullptr, 10) : 0;
+
+	std::vector< epw::Cardset > ranges[2];
+	for(size_t r = 0; r < 2; ++r)
+	{
+		epw::cmatch::CardMatch cm;
+		if(!epw::parse_range(epw::narrow_to_epw(argv[2 + r]), cm, 4, 4))
+		{
+			epw::cout << _T("Failed to parse range ") << (r + 1) << std::endl;
+			return 1;
+		}
+
+		std::vector< epw::Cardset >& range = ranges[r];
+		epw::cmatch::enum_ftr ftr = [&range](epw::Card const cards[], size_t count, size_t lex_index)
+			{
+				range.push_back(epw::Cardset(cards, cards + count));
+			}
+		;
+		cm.enumerate_fast(ftr);
+	}
+
+	epw::sim::LookupTables::flags_t flags;
+	flags.set(epw::sim::LookupTables::OMAHA_EVAL);
+	if(!epw::sim::LookupTables::initialize(flags))
+	{
+		epw::cout << _T("Failed to initialize lookup tables") << std::endl;
+		return 1;
+	}
+
+	std::vector< epw::sim::PreflopMatchupStore::hand_pair_t > matchups;
+	for(epw::Cardset const& h1: ranges[0])
+	{
+		for(epw::Cardset const& h2: ranges[1])
+		{
+			if(!h1.contains_any(h2))
+			{
+				matchups.push_back(epw::sim::PreflopMatchupStore::hand_pair_t(h1, h2));
+			}
+		}
+	}
+
+	std::chrono::system_clock::time_point commenced = std::chrono::system_clock::now();
+
+	if(!epw::sim::PreflopMatchupStore::build(matchups, filename, num_threads))
+	{
+		epw::cout << _T("Failed to build matchup store") << std::endl;
+		return 1;
+	}
+
+	std::chrono::duration< double, std::ratio< 1 > > const secs = std::chrono::system_clock::now() - commenced;
+
+	epw::sim::PreflopMatchupStore store;
+	store.open(filename);
+	epw::cout << matchups.size() << _T(" matchups, ") << store.size() << _T(" distinct, written to ") << filename
+		<< _T(" in ") << secs.count() << _T("s") << std::endl;
+
+	return 0;
+}
+
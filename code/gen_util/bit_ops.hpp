@@ -0,0 +1,95 @@
+// bit_ops.hpp
+/*!
+Portable wrappers for bit manipulation intrinsics.
+*/
+
+#ifndef EPW_BIT_OPS_H
+#define EPW_BIT_OPS_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace epw {
+
+	/*! Index of the least significant set bit. v must be non-zero. */
+	inline size_t lowest_bit_index(uint64_t const v)
+	{
+		assert(v != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long idx;
+		_BitScanForward64(&idx, v);
+		return idx;
+#elif defined(_MSC_VER)
+		unsigned long idx;
+		if(_BitScanForward(&idx, static_cast< unsigned long >(v)))
+		{
+			return idx;
+		}
+		_BitScanForward(&idx, static_cast< unsigned long >(v >> 32));
+		return idx + 32;
+#else
+		return static_cast< size_t >(__builtin_ctzll(v));
+#endif
+	}
+
+	/*! v with its least significant set bit cleared */
+	inline uint64_t clear_lowest_bit(uint64_t const v)
+	{
+		return v & (v - 1);
+	}
+
+	/*! Number of set bits */
+	inline size_t popcount(uint64_t v)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		return static_cast< size_t >(__popcnt64(v));
+#elif defined(_MSC_VER)
+		return static_cast< size_t >(__popcnt(static_cast< unsigned int >(v)) + __popcnt(static_cast< unsigned int >(v >> 32)));
+#else
+		return static_cast< size_t >(__builtin_popcountll(v));
+#endif
+	}
+
+	/*! Index of the n'th (from 0) least significant set bit. v must have more than n bits set. */
+	inline size_t select_bit(uint64_t v, size_t n)
+	{
+		assert(popcount(v) > n);
+		for(; n > 0; --n)
+		{
+			v = clear_lowest_bit(v);
+		}
+		return lowest_bit_index(v);
+	}
+
+	/*! Full 128 bit product of a and b. Returns the low 64 bits and stores the high 64 bits in hi. */
+	inline uint64_t mul_128(uint64_t const a, uint64_t const b, uint64_t& hi)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		return _umul128(a, b, &hi);
+#elif defined(_MSC_VER)
+		uint64_t const a_lo = a & 0xffffffff, a_hi = a >> 32;
+		uint64_t const b_lo = b & 0xffffffff, b_hi = b >> 32;
+		uint64_t const ll = a_lo * b_lo;
+		uint64_t const lh = a_lo * b_hi;
+		uint64_t const hl = a_hi * b_lo;
+		uint64_t const mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+		hi = a_hi * b_hi + (lh >> 32) + (hl >> 32) + (mid >> 32);
+		return (mid << 32) | (ll & 0xffffffff);
+#else
+		unsigned __int128 const r = static_cast< unsigned __int128 >(a) * b;
+		hi = static_cast< uint64_t >(r >> 64);
+		return static_cast< uint64_t >(r);
+#endif
+	}
+
+}
+
+
+#endif
+
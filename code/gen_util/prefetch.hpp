@@ -0,0 +1,30 @@
+// prefetch.hpp
+/*!
+Portable wrapper for software prefetch hints.
+*/
+
+#ifndef EPW_PREFETCH_H
+#define EPW_PREFETCH_H
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+
+namespace epw {
+
+	/*! Hints that the cache line containing p will be read soon */
+	inline void prefetch(void const* const p)
+	{
+#if defined(_MSC_VER)
+		_mm_prefetch(static_cast< char const* >(p), _MM_HINT_T0);
+#else
+		__builtin_prefetch(p);
+#endif
+	}
+
+}
+
+
+#endif
+
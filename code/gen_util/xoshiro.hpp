@@ -0,0 +1,149 @@
+// xoshiro.hpp
+/*!
+The xoshiro256** pseudo random number generator (Blackman and Vigna), along with unbiased bounded integer draws using
+multiply-shift rather than division.
+*/
+
+#ifndef EPW_XOSHIRO_H
+#define EPW_XOSHIRO_H
+
+#include "bit_ops.hpp"
+
+#include <cstdint>
+#include <limits>
+
+
+namespace epw {
+
+	/*!
+	Satisfies the requirements of a uniform random bit generator, so may be used with boost/std distributions. jump() advances the
+	state by 2^128 draws, so generators seeded identically and then jumped different numbers of times produce non-overlapping streams.
+	*/
+	class xoshiro256starstar
+	{
+	public:
+		typedef uint64_t result_type;
+
+	public:
+		explicit xoshiro256starstar(uint64_t const _seed = 0)
+		{
+			seed(_seed);
+		}
+
+		static inline result_type min()
+		{
+			return 0;
+		}
+
+		static inline result_type max()
+		{
+			return std::numeric_limits< result_type >::max();
+		}
+
+		/*! Expands a 64 bit seed to the full state using splitmix64, as recommended by the authors */
+		inline void seed(uint64_t s)
+		{
+			for(size_t i = 0; i < 4; ++i)
+			{
+				s += 0x9e3779b97f4a7c15ull;
+				uint64_t z = s;
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+				m_state[i] = z ^ (z >> 31);
+			}
+		}
+
+		inline result_type operator() ()
+		{
+			uint64_t const result = rotl(m_state[1] * 5, 7) * 9;
+			uint64_t const t = m_state[1] << 17;
+
+			m_state[2] ^= m_state[0];
+			m_state[3] ^= m_state[1];
+			m_state[1] ^= m_state[2];
+			m_state[0] ^= m_state[3];
+
+			m_state[2] ^= t;
+			m_state[3] = rotl(m_state[3], 45);
+
+			return result;
+		}
+
+		/*! Equivalent to 2^128 calls to operator() */
+		void jump()
+		{
+			static uint64_t const JUMP[] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+
+			uint64_t s[4] = { 0, 0, 0, 0 };
+			for(size_t i = 0; i < 4; ++i)
+			{
+				for(size_t b = 0; b < 64; ++b)
+				{
+					if(JUMP[i] & ((uint64_t)1 << b))
+					{
+						for(size_t j = 0; j < 4; ++j)
+						{
+							s[j] ^= m_state[j];
+						}
+					}
+					(*this)();
+				}
+			}
+
+			for(size_t j = 0; j < 4; ++j)
+			{
+				m_state[j] = s[j];
+			}
+		}
+
+	private:
+		static inline uint64_t rotl(uint64_t const x, int const k)
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+
+	private:
+		uint64_t m_state[4];
+	};
+
+	/*! 64 random bits from a generator producing either exactly 32 or 64 bits per draw */
+	template < typename Gen >
+	inline uint64_t rand_64(Gen& gen)
+	{
+		if(Gen::max() - Gen::min() >= std::numeric_limits< uint64_t >::max())
+		{
+			return static_cast< uint64_t >(gen() - Gen::min());
+		}
+		else
+		{
+			uint64_t const hi = static_cast< uint64_t >(gen() - Gen::min());
+			return (hi << 32) | static_cast< uint64_t >(gen() - Gen::min());
+		}
+	}
+
+	/*!
+	Uniform integer in [0, n), n > 0, using Lemire's multiply-shift method: the high 64 bits of a 64 bit random value multiplied by n,
+	with a rejection step (almost never taken for the small n used in simulations) that removes the bias. Works with any uniform random
+	bit generator, combining two draws if it produces only 32 bits.
+	*/
+	template < typename Gen >
+	inline uint64_t rand_below(Gen& gen, uint64_t const n)
+	{
+		uint64_t hi;
+		uint64_t lo = mul_128(rand_64(gen), n, hi);
+		if(lo < n)
+		{
+			uint64_t const threshold = (0 - n) % n;
+			while(lo < threshold)
+			{
+				lo = mul_128(rand_64(gen), n, hi);
+			}
+		}
+		return hi;
+	}
+
+}
+
+
+#endif
+
@@ -0,0 +1,128 @@
+// holdem_hand_eval.cpp
+
+#include "holdem_hand_eval.hpp"
+#include "poker_hand_eval.hpp"
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+
+namespace epw {
+
+	HoldemHandEval::Tables const* HoldemHandEval::s_tables = nullptr;
+
+	bool HoldemHandEval::initialize()
+	{
+		// Storage for the tables when generated rather than mapped, allocated on first use
+		static std::unique_ptr< Tables > generated(new Tables());
+
+		Tables& t = *generated;
+		if(!generate_rank_states(t) || !generate_flush_vals(t))
+		{
+			return false;
+		}
+
+		s_tables = &t;
+		return true;
+	}
+
+	bool HoldemHandEval::initialize(Tables const& tables)
+	{
+		s_tables = &tables;
+		return true;
+	}
+
+	bool HoldemHandEval::generate_rank_states(Tables& t)
+	{
+		typedef std::array< uint8_t, Card::RANK_COUNT > rank_counts_t;
+
+		// Rank multisets are keyed by their rank counts as base 5 digits
+		std::array< uint32_t, Card::RANK_COUNT > digit;
+		digit[0] = 1;
+		for(size_t r = 1; r < Card::RANK_COUNT; ++r)
+		{
+			digit[r] = digit[r - 1] * (Card::SUIT_COUNT + 1);
+		}
+
+		std::unordered_map< uint32_t, uint32_t > state_indices;
+		std::vector< std::pair< uint32_t, rank_counts_t > > states;
+		state_indices.reserve(NUM_RANK_STATES);
+		states.reserve(NUM_RANK_STATES);
+
+		// Breadth first from the empty multiset, so every state is processed after all of its predecessors
+		state_indices[0] = 0;
+		states.push_back(std::make_pair((uint32_t)0, rank_counts_t()));
+		for(size_t idx = 0; idx < states.size(); ++idx)
+		{
+			uint32_t const key = states[idx].first;
+			rank_counts_t const counts = states[idx].second;
+
+			size_t count = 0;
+			Cardset cards;
+			for(size_t r = 0; r < Card::RANK_COUNT; ++r)
+			{
+				for(size_t s = 0; s < counts[r]; ++s)
+				{
+					cards.insert(Card((Card::rank_t)r, (Card::suit_t)s));
+				}
+				count += counts[r];
+			}
+
+			t.rank_vals[idx] = PokerHandEval::EvaluateHandFtr< PokerHandEval::NoFlushPossible >()(cards, (int)count);
+
+			for(size_t r = 0; r < Card::RANK_COUNT; ++r)
+			{
+				if(count == MAX_CARDS || counts[r] == Card::SUIT_COUNT)
+				{
+					// Unreachable with valid cards
+					t.next_state[idx][r] = 0;
+					continue;
+				}
+
+				uint32_t const next_key = key + digit[r];
+				auto it = state_indices.find(next_key);
+				if(it == state_indices.end())
+				{
+					if(states.size() == NUM_RANK_STATES)
+					{
+						return false;
+					}
+
+					rank_counts_t next_counts = counts;
+					++next_counts[r];
+					it = state_indices.insert(std::make_pair(next_key, (uint32_t)states.size())).first;
+					states.push_back(std::make_pair(next_key, next_counts));
+				}
+
+				t.next_state[idx][r] = it->second;
+			}
+		}
+
+		return states.size() == NUM_RANK_STATES;
+	}
+
+	bool HoldemHandEval::generate_flush_vals(Tables& t)
+	{
+		for(uint32_t rs = 0; rs < RANKSET_COUNT; ++rs)
+		{
+			Cardset cards;
+			for(size_t r = 0; r < Card::RANK_COUNT; ++r)
+			{
+				if(rs & (1 << r))
+				{
+					cards.insert(Card((Card::rank_t)r, Card::CLUBS));
+				}
+			}
+
+			HandVal val = HandVal::NOTHING;
+			PokerHandEval::test_for_flush_hand< PokerHandEval::ClubFlushPossible >(cards, val);
+			t.flush_vals[rs] = val;
+		}
+
+		return true;
+	}
+
+}
+
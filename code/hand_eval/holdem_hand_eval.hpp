@@ -0,0 +1,153 @@
+// holdem_hand_eval.hpp
+/*!
+Direct lookup Hold'em hand evaluation, for up to 7 cards. Cards are fed in one at a time, and the evaluation state after any number
+of cards can be kept and extended, so that for example a board can be processed once and then completed with each player's hole
+cards in turn.
+
+Non-flush: The rank multiset of the cards seen so far is a state in a precomputed state machine, with a transition for each rank.
+Every state stores the best non-flush value of its ranks, so that evaluation is a lookup per card plus one for the value.
+
+Flush: The cards themselves are accumulated as a Cardset, and each suit's rankset indexes a table of flush values, which is zero
+unless the rankset has at least 5 ranks.
+*/
+
+#ifndef EPW_HOLDEM_HAND_EVAL_H
+#define EPW_HOLDEM_HAND_EVAL_H
+
+#include "poker_hand_value.hpp"
+
+#include "poker_core/cardset.hpp"
+#include "poker_core/hand.hpp"
+#include "poker_core/board.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+
+namespace epw {
+
+	class HoldemHandEval
+	{
+	public:
+		enum {
+			MAX_CARDS = holdem::CARDS_PER_HAND + MAX_BOARD_CARDS,
+
+			/*
+			Number of multisets of at most 7 ranks, with no rank appearing more than 4 times:
+			1 + 13 + 91 + 455 + 1820 + (6188 - 13) + (18564 - 169) + (50388 - 1183)
+			*/
+			NUM_RANK_STATES = 76155,
+
+			RANKSET_COUNT = 1 << Card::RANK_COUNT,
+		};
+
+		/*!
+		Evaluation state for the cards added so far.
+		*/
+		struct State
+		{
+			uint32_t		rank_state;
+			Cardset			cards;
+
+			State(): rank_state(0), cards()
+			{}
+		};
+
+		/*!
+		All of the evaluator's tables, as a single block so that LookupTables can write it to and map it from a blob file. Any change
+		to its layout must bump the blob version.
+		*/
+		struct Tables
+		{
+			/*! Transitions from a rank state on the addition of a card of a given rank */
+			uint32_t	next_state[NUM_RANK_STATES][Card::RANK_COUNT];
+
+			/*! Best non-flush value of each rank state */
+			HandVal		rank_vals[NUM_RANK_STATES];
+
+			/*! Flush (or straight flush) value of a single suit's rankset, zero for less than 5 ranks */
+			HandVal		flush_vals[RANKSET_COUNT];
+		};
+
+	public:
+		/*! Generates the tables */
+		static bool initialize();
+
+		/*! Uses tables which were generated elsewhere, such as mapped from a file. They must remain valid while the evaluator is used. */
+		static bool initialize(Tables const& tables);
+
+		static inline bool is_initialized()
+		{
+			return s_tables != nullptr;
+		}
+
+		/*! The tables in use, or null if not initialized */
+		static inline Tables const* get_tables()
+		{
+			return s_tables;
+		}
+
+		static inline void add_card(State& state, Card const& c)
+		{
+			assert(!state.cards.contains(c));
+
+			state.rank_state = s_tables->next_state[state.rank_state][c.get_rank()];
+			state.cards.insert(c);
+		}
+
+		static inline State with_card(State state, Card const& c)
+		{
+			add_card(state, c);
+			return state;
+		}
+
+		static inline HandVal evaluate(State const& state)
+		{
+			HandVal const* const flush_vals = s_tables->flush_vals;
+			HandVal const flush = std::max(
+				std::max(flush_vals[state.cards.get_rankset(Card::CLUBS)], flush_vals[state.cards.get_rankset(Card::DIAMONDS)]),
+				std::max(flush_vals[state.cards.get_rankset(Card::HEARTS)], flush_vals[state.cards.get_rankset(Card::SPADES)])
+				);
+			return std::max(s_tables->rank_vals[state.rank_state], flush);
+		}
+
+		/*! Evaluates the hole cards h on top of the already processed board state */
+		template < typename HandCards >
+		static inline HandVal evaluate(HandCards const& h, State const& board_state)
+		{
+			State state = board_state;
+			add_card(state, h[0]);
+			add_card(state, h[1]);
+			return evaluate(state);
+		}
+
+		static inline State prepare_board(Board const& b)
+		{
+			State state;
+			for(size_t i = 0; i < b.count; ++i)
+			{
+				add_card(state, b[i]);
+			}
+			return state;
+		}
+
+		template < typename HandCards >
+		static inline HandVal evaluate(HandCards const& h, Board const& b)
+		{
+			return evaluate(h, prepare_board(b));
+		}
+
+	private:
+		static bool generate_rank_states(Tables& t);
+		static bool generate_flush_vals(Tables& t);
+
+	private:
+		static Tables const* s_tables;
+	};
+
+}
+
+
+#endif
+
@@ -0,0 +1,246 @@
+// omaha_hand_eval.cpp
+
+#include "omaha_hand_eval.hpp"
+#include "poker_hand_eval.hpp"
+
+#include <memory>
+
+
+namespace epw {
+
+	OmahaHandEval::Tables const* OmahaHandEval::s_tables = nullptr;
+
+	namespace {
+
+		/*! Evaluates a set of ranks ignoring flushes, where each repeat of a rank is assigned the next suit */
+		template < size_t N >
+		inline HandVal evaluate_ranks_no_flush(std::array< Card::rank_t, N > const& ranks)
+		{
+			std::array< size_t, Card::RANK_COUNT > used = {};
+			Cardset cards;
+			for(Card::rank_t r: ranks)
+			{
+				cards.insert(Card(r, (Card::suit_t)used[r]++));
+			}
+			return PokerHandEval::EvaluateHandFtr< PokerHandEval::NoFlushPossible >()(cards, (int)N);
+		}
+
+		/*! Evaluates 5 distinct ranks all of the same suit */
+		inline HandVal evaluate_suited_ranks(std::array< Card::rank_t, 5 > const& ranks)
+		{
+			Cardset cards;
+			for(Card::rank_t r: ranks)
+			{
+				cards.insert(Card(r, Card::CLUBS));
+			}
+			return PokerHandEval::EvaluateHandFtr< PokerHandEval::ClubFlushPossible >()(cards, 5);
+		}
+
+	}
+
+	bool OmahaHandEval::initialize()
+	{
+		// Storage for the tables when generated rather than mapped, allocated on first use
+		static std::unique_ptr< Tables > generated(new Tables());
+
+		Tables& t = *generated;
+		generate_indices(t);
+		if(!generate_rank_vals(t) || !generate_flush_vals(t))
+		{
+			return false;
+		}
+
+		s_tables = &t;
+		return true;
+	}
+
+	bool OmahaHandEval::initialize(Tables const& tables)
+	{
+		s_tables = &tables;
+		return true;
+	}
+
+	void OmahaHandEval::generate_indices(Tables& t)
+	{
+		// Number of k element multisets drawn from n ranks
+		for(size_t n = 0; n < Card::RANK_COUNT; ++n)
+		{
+			t.multiset_lex[n][0] = 1;
+			for(size_t k = 1; k <= MAX_BOARD_CARDS; ++k)
+			{
+				t.multiset_lex[n][k] = n == 0 ? 0 : t.multiset_lex[n - 1][k] + t.multiset_lex[n][k - 1];
+			}
+		}
+
+		std::fill(std::begin(t.board_row_offsets), std::end(t.board_row_offsets), 0);
+		t.board_row_offsets[4] = combinations_w_replacement::ct< Card::RANK_COUNT, 3 >::res;
+		t.board_row_offsets[5] = t.board_row_offsets[4] + combinations_w_replacement::ct< Card::RANK_COUNT, 4 >::res;
+
+		size_t idx = 0, suited_idx = 0;
+		for(size_t r1 = 0; r1 < Card::RANK_COUNT; ++r1)
+		{
+			for(size_t r2 = 0; r2 <= r1; ++r2)
+			{
+				t.suited_idx_by_two_rank_idx[idx] = r2 != r1 ? (uint8_t)suited_idx : 0;
+				t.two_rank_idx[r1][r2] = t.two_rank_idx[r2][r1] = (uint8_t)idx++;
+				if(r2 != r1)
+				{
+					t.suited_two_rank_idx[r1][r2] = t.suited_two_rank_idx[r2][r1] = (uint8_t)suited_idx++;
+				}
+			}
+			t.suited_two_rank_idx[r1][r1] = 0;	// Not possible, but keep lookups in bounds
+		}
+	}
+
+	bool OmahaHandEval::generate_rank_vals(Tables& t)
+	{
+		std::fill(&t.rank_vals[0][0], &t.rank_vals[0][0] + NUM_BOARD_RANK_ROWS * NUM_TWO_RANK_COMBOS, HandVal(HandVal::NOTHING));
+
+		// Enumerate every multiset of 5 board ranks in descending order, filling rows for its 3 and 4 rank prefixes along the way
+		std::array< Card::rank_t, MAX_BOARD_CARDS > b;
+		std::array< size_t, Card::RANK_COUNT > counts = {};
+		std::array< bool, NUM_BOARD_RANK_ROWS > done = {};
+
+		struct fill_row
+		{
+			static void apply(Tables& t, std::array< Card::rank_t, MAX_BOARD_CARDS > const& b, size_t const count, std::array< size_t, Card::RANK_COUNT > const& counts)
+			{
+				size_t const row = board_rank_row(t, b.data(), count);
+
+				for(size_t h1 = 0; h1 < Card::RANK_COUNT; ++h1)
+				{
+					for(size_t h2 = 0; h2 <= h1; ++h2)
+					{
+						if(counts[h1] + 1 + (h1 == h2 ? 1 : 0) > Card::SUIT_COUNT || counts[h2] + 1 + (h1 == h2 ? 1 : 0) > Card::SUIT_COUNT)
+						{
+							continue;
+						}
+
+						HandVal best = HandVal::NOTHING;
+						for(size_t b1 = 0; b1 < count - 2; ++b1)
+						{
+							for(size_t b2 = b1 + 1; b2 < count - 1; ++b2)
+							{
+								for(size_t b3 = b2 + 1; b3 < count; ++b3)
+								{
+									std::array< Card::rank_t, 5 > const ranks = {
+										(Card::rank_t)h1, (Card::rank_t)h2, b[b1], b[b2], b[b3]
+									};
+									best = std::max(best, evaluate_ranks_no_flush(ranks));
+								}
+							}
+						}
+
+						t.rank_vals[row][t.two_rank_idx[h1][h2]] = best;
+					}
+				}
+			}
+		};
+
+		for(int r1 = Card::ACE; r1 >= Card::DEUCE; --r1)
+		{
+			b[0] = (Card::rank_t)r1;
+			++counts[r1];
+			for(int r2 = r1; r2 >= Card::DEUCE; --r2)
+			{
+				b[1] = (Card::rank_t)r2;
+				++counts[r2];
+				for(int r3 = r2; r3 >= Card::DEUCE; --r3)
+				{
+					b[2] = (Card::rank_t)r3;
+					if(++counts[r3] <= Card::SUIT_COUNT && !done[board_rank_row(t, b.data(), 3)])
+					{
+						done[board_rank_row(t, b.data(), 3)] = true;
+						fill_row::apply(t, b, 3, counts);
+					}
+					for(int r4 = r3; r4 >= Card::DEUCE; --r4)
+					{
+						b[3] = (Card::rank_t)r4;
+						if(++counts[r4] <= Card::SUIT_COUNT && counts[r3] <= Card::SUIT_COUNT && !done[board_rank_row(t, b.data(), 4)])
+						{
+							done[board_rank_row(t, b.data(), 4)] = true;
+							fill_row::apply(t, b, 4, counts);
+						}
+						for(int r5 = r4; r5 >= Card::DEUCE; --r5)
+						{
+							b[4] = (Card::rank_t)r5;
+							if(++counts[r5] <= Card::SUIT_COUNT && counts[r4] <= Card::SUIT_COUNT && counts[r3] <= Card::SUIT_COUNT)
+							{
+								fill_row::apply(t, b, 5, counts);
+							}
+							--counts[r5];
+						}
+						--counts[r4];
+					}
+					--counts[r3];
+				}
+				--counts[r2];
+			}
+			--counts[r1];
+		}
+		return true;
+	}
+
+	bool OmahaHandEval::generate_flush_vals(Tables& t)
+	{
+		std::fill(std::begin(t.flush_board_rows), std::end(t.flush_board_rows), (uint16_t)NO_FLUSH_ROW);
+		std::fill(&t.flush_vals[0][0], &t.flush_vals[0][0] + NUM_FLUSH_BOARD_ROWS * NUM_SUITED_TWO_RANK_COMBOS, HandVal(HandVal::NOTHING));
+
+		size_t row = 0;
+		for(uint32_t rs = 0; rs < RANKSET_COUNT; ++rs)
+		{
+			size_t const n = nBitsTable[rs];
+			if(n < MIN_BOARD_CARDS || n > MAX_BOARD_CARDS)
+			{
+				continue;
+			}
+
+			t.flush_board_rows[rs] = (uint16_t)row;
+
+			std::array< Card::rank_t, MAX_BOARD_CARDS > b;
+			size_t count = 0;
+			for(size_t r = 0; r < Card::RANK_COUNT; ++r)
+			{
+				if(rs & (1 << r))
+				{
+					b[count++] = (Card::rank_t)r;
+				}
+			}
+
+			for(size_t h1 = 0; h1 < Card::RANK_COUNT; ++h1)
+			{
+				for(size_t h2 = 0; h2 < h1; ++h2)
+				{
+					if(rs & ((1 << h1) | (1 << h2)))
+					{
+						// Hand cards of the flush suit can't share a rank with suited board cards
+						continue;
+					}
+
+					HandVal best = HandVal::NOTHING;
+					for(size_t b1 = 0; b1 < count - 2; ++b1)
+					{
+						for(size_t b2 = b1 + 1; b2 < count - 1; ++b2)
+						{
+							for(size_t b3 = b2 + 1; b3 < count; ++b3)
+							{
+								std::array< Card::rank_t, 5 > const ranks = {
+									(Card::rank_t)h1, (Card::rank_t)h2, b[b1], b[b2], b[b3]
+								};
+								best = std::max(best, evaluate_suited_ranks(ranks));
+							}
+						}
+					}
+
+					t.flush_vals[row][t.suited_two_rank_idx[h1][h2]] = best;
+				}
+			}
+
+			++row;
+		}
+
+		return row == NUM_FLUSH_BOARD_ROWS;
+	}
+
+}
+
@@ -0,0 +1,291 @@
+// omaha_hand_eval.hpp
+/*!
+Direct lookup Omaha hand evaluation. Rather than evaluating every one of the (up to) 60 five card combinations of two hand cards
+and three board cards, the evaluation is split into a non-flush part and a flush part:
+
+Non-flush: For a given multiset of board ranks, the best non-flush value obtainable with any two given hand ranks is fixed, so is
+precomputed into a table with a row per board rank multiset (3, 4 or 5 cards) and a column per two-rank combo. A hand is then
+evaluated with a single lookup for each of its 6 two card combos.
+
+Flush: A flush is only possible in the single suit (if any) with at least 3 cards on the board. A second table gives, for each
+possible suited board rankset, the best flush value made with each suited pair of distinct hand ranks.
+*/
+
+#ifndef EPW_OMAHA_HAND_EVAL_H
+#define EPW_OMAHA_HAND_EVAL_H
+
+#include "poker_hand_value.hpp"
+
+#include "poker_core/cardset.hpp"
+#include "poker_core/hand.hpp"
+#include "poker_core/board.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+
+namespace epw {
+
+	class OmahaHandEval
+	{
+	public:
+		/*!
+		Everything about a board that is needed for hand evaluation. Calculated once per board, after which any number of hands can be
+		evaluated against it.
+		*/
+		struct BoardKey
+		{
+			uint16_t			rank_row;		// Row into the non-flush table
+			uint16_t			flush_row;		// Row into the flush table, only valid if flush_suit is not UNKNOWN_SUIT
+			Card::suit_t		flush_suit;		// The suit in which a flush is possible, or UNKNOWN_SUIT
+			bool				valid;			// False if there are not enough board cards for an evaluation
+
+			BoardKey(): rank_row(0), flush_row(0), flush_suit(Card::UNKNOWN_SUIT), valid(false)
+			{}
+		};
+
+		enum {
+			MIN_BOARD_CARDS = 3,
+			NUM_TWO_RANK_COMBOS = combinations_w_replacement::ct< Card::RANK_COUNT, 2 >::res,		// 91
+			NUM_SUITED_TWO_RANK_COMBOS = combinations::ct< Card::RANK_COUNT, 2 >::res,				// 78
+			NUM_HAND_TWO_CARD_COMBOS = combinations::ct< omaha::CARDS_PER_HAND, 2 >::res,			// 6
+
+			NUM_BOARD_RANK_ROWS =
+				combinations_w_replacement::ct< Card::RANK_COUNT, 3 >::res +
+				combinations_w_replacement::ct< Card::RANK_COUNT, 4 >::res +
+				combinations_w_replacement::ct< Card::RANK_COUNT, 5 >::res,			// 455 + 1820 + 6188
+			NUM_FLUSH_BOARD_ROWS =
+				combinations::ct< Card::RANK_COUNT, 3 >::res +
+				combinations::ct< Card::RANK_COUNT, 4 >::res +
+				combinations::ct< Card::RANK_COUNT, 5 >::res,						// 286 + 715 + 1287
+
+			RANKSET_COUNT = 1 << Card::RANK_COUNT,
+			NO_FLUSH_ROW = 0xffff,
+		};
+
+		/*!
+		All of the evaluator's tables, as a single block so that LookupTables can write it to and map it from a blob file. Any change
+		to its layout must bump the blob version.
+		*/
+		struct Tables
+		{
+			/*! Non-flush value for [board rank multiset][two-rank combo] */
+			HandVal		rank_vals[NUM_BOARD_RANK_ROWS][NUM_TWO_RANK_COMBOS];
+
+			/*! Flush value for [suited board rankset][suited two-rank combo of distinct ranks] */
+			HandVal		flush_vals[NUM_FLUSH_BOARD_ROWS][NUM_SUITED_TWO_RANK_COMBOS];
+
+			/*! Order independent maps from two ranks to a column index in the above tables */
+			uint8_t		two_rank_idx[Card::RANK_COUNT][Card::RANK_COUNT];
+			uint8_t		suited_two_rank_idx[Card::RANK_COUNT][Card::RANK_COUNT];
+
+			/*! Maps a column of rank_vals to the corresponding column of flush_vals (zero for pairs, which can't be suited) */
+			uint8_t		suited_idx_by_two_rank_idx[NUM_TWO_RANK_COMBOS];
+
+			/*! Maps from a 13 bit suited board rankset to a row of flush_vals, or NO_FLUSH_ROW for ranksets of less than 3 or more than 5 ranks */
+			uint16_t	flush_board_rows[RANKSET_COUNT];
+
+			/*! multiset_lex[n][k] is the number of k element rank multisets with all elements less than n */
+			uint32_t	multiset_lex[Card::RANK_COUNT][MAX_BOARD_CARDS + 1];
+
+			/*! Offset of the first row of rank_vals for each board size */
+			uint32_t	board_row_offsets[MAX_BOARD_CARDS + 1];
+		};
+
+	public:
+		/*! Generates the tables */
+		static bool initialize();
+
+		/*! Uses tables which were generated elsewhere, such as mapped from a file. They must remain valid while the evaluator is used. */
+		static bool initialize(Tables const& tables);
+
+		static inline bool is_initialized()
+		{
+			return s_tables != nullptr;
+		}
+
+		/*! The tables in use, or null if not initialized */
+		static inline Tables const* get_tables()
+		{
+			return s_tables;
+		}
+
+		static inline BoardKey prepare_board(Board const& b)
+		{
+			BoardKey key;
+			if(b.count < MIN_BOARD_CARDS)
+			{
+				return key;
+			}
+
+			std::array< Card::rank_t, MAX_BOARD_CARDS > ranks;
+			std::array< size_t, Card::SUIT_COUNT > suit_counts = {};
+			Cardset cards;
+			for(size_t i = 0; i < b.count; ++i)
+			{
+				ranks[i] = b[i].get_rank();
+				++suit_counts[b[i].get_suit()];
+				cards.insert(b[i]);
+			}
+
+			std::sort(ranks.begin(), ranks.begin() + b.count, std::greater< Card::rank_t >());
+			key.rank_row = static_cast< uint16_t >(board_rank_row(*s_tables, ranks.data(), b.count));
+
+			// With at most 5 board cards, at most one suit can have 3 or more
+			for(size_t s = 0; s < Card::SUIT_COUNT; ++s)
+			{
+				if(suit_counts[s] >= MIN_BOARD_CARDS)
+				{
+					key.flush_suit = (Card::suit_t)s;
+					key.flush_row = s_tables->flush_board_rows[cards.get_rankset((Card::suit_t)s)];
+					break;
+				}
+			}
+
+			key.valid = true;
+			return key;
+		}
+
+		/*!
+		HandCards is any type providing operator[] access to the 4 Cards of an omaha hand.
+		*/
+		template < typename HandCards >
+		static inline HandVal evaluate(HandCards const& h, BoardKey const& key)
+		{
+			if(!key.valid)
+			{
+				return HandVal::NOTHING;
+			}
+
+			Card::rank_t const r0 = h[0].get_rank();
+			Card::rank_t const r1 = h[1].get_rank();
+			Card::rank_t const r2 = h[2].get_rank();
+			Card::rank_t const r3 = h[3].get_rank();
+
+			HandVal const* const row = s_tables->rank_vals[key.rank_row];
+			uint8_t const (*const tr_idx)[Card::RANK_COUNT] = s_tables->two_rank_idx;
+			HandVal best = std::max(
+				std::max(std::max(row[tr_idx[r0][r1]], row[tr_idx[r0][r2]]), std::max(row[tr_idx[r0][r3]], row[tr_idx[r1][r2]])),
+				std::max(row[tr_idx[r1][r3]], row[tr_idx[r2][r3]])
+				);
+
+			if(key.flush_suit != Card::UNKNOWN_SUIT)
+			{
+				HandVal const* const flush_row = s_tables->flush_vals[key.flush_row];
+				for(size_t a = 0; a < omaha::CARDS_PER_HAND - 1; ++a)
+				{
+					if(h[a].get_suit() != key.flush_suit)
+					{
+						continue;
+					}
+
+					for(size_t b = a + 1; b < omaha::CARDS_PER_HAND; ++b)
+					{
+						if(h[b].get_suit() == key.flush_suit)
+						{
+							best = std::max(best, flush_row[s_tables->suited_two_rank_idx[h[a].get_rank()][h[b].get_rank()]]);
+						}
+					}
+				}
+			}
+
+			return best;
+		}
+
+		/*!
+		As above, but for a hand given as its 6 two card combos. TwoRankCombos is any type providing operator[] access to them, each
+		with a lex_idx as per Tables::two_rank_idx and a suit, which is UNKNOWN_SUIT unless both cards are of that suit (as per
+		LookupTables::OmahaHand::SuitedTwoRankCombo). Saves recalculating the column indices from the cards on every evaluation.
+		*/
+		template < typename TwoRankCombos >
+		static inline HandVal evaluate_combos(TwoRankCombos const& combos, BoardKey const& key)
+		{
+			if(!key.valid)
+			{
+				return HandVal::NOTHING;
+			}
+
+			HandVal const* const row = s_tables->rank_vals[key.rank_row];
+			HandVal best = HandVal::NOTHING;
+			for(size_t i = 0; i < NUM_HAND_TWO_CARD_COMBOS; ++i)
+			{
+				best = std::max(best, row[combos[i].lex_idx]);
+			}
+
+			if(key.flush_suit != Card::UNKNOWN_SUIT)
+			{
+				HandVal const* const flush_row = s_tables->flush_vals[key.flush_row];
+				for(size_t i = 0; i < NUM_HAND_TWO_CARD_COMBOS; ++i)
+				{
+					if(combos[i].suit == key.flush_suit)
+					{
+						best = std::max(best, flush_row[s_tables->suited_idx_by_two_rank_idx[combos[i].lex_idx]]);
+					}
+				}
+			}
+
+			return best;
+		}
+
+		template < typename HandCards >
+		static inline HandVal evaluate(HandCards const& h, Board const& b)
+		{
+			return evaluate(h, prepare_board(b));
+		}
+
+		/*!
+		Fills per-board tables of the best value obtainable with each two-rank combo, indexed by the combo's lexicographical index
+		(as per LookupTables::OmahaHand::SuitedTwoRankCombo). nonflush is for any two hand cards; suited is for two hand cards both of
+		key.flush_suit, and is only filled if the board has a flush suit.
+		*/
+		static inline void build_rank_pair_table(BoardKey const& key, HandVal nonflush[], HandVal suited[])
+		{
+			assert(key.valid);
+
+			HandVal const* const row = s_tables->rank_vals[key.rank_row];
+			std::copy(row, row + NUM_TWO_RANK_COMBOS, nonflush);
+
+			if(key.flush_suit != Card::UNKNOWN_SUIT)
+			{
+				HandVal const* const flush_row = s_tables->flush_vals[key.flush_row];
+				size_t idx = 0;
+				for(size_t r1 = 0; r1 < Card::RANK_COUNT; ++r1)
+				{
+					for(size_t r2 = 0; r2 < r1; ++r2, ++idx)
+					{
+						suited[idx] = std::max(row[idx], flush_row[s_tables->suited_two_rank_idx[r1][r2]]);
+					}
+					// Pair, so can't be suited
+					suited[idx] = row[idx];
+					++idx;
+				}
+			}
+		}
+
+	private:
+		/*! ranks must be sorted highest first */
+		static inline size_t board_rank_row(Tables const& t, Card::rank_t const ranks[], size_t const count)
+		{
+			size_t row = t.board_row_offsets[count];
+			for(size_t i = 0; i < count; ++i)
+			{
+				row += t.multiset_lex[ranks[i]][count - i];
+			}
+			return row;
+		}
+
+		static void generate_indices(Tables& t);
+		static bool generate_rank_vals(Tables& t);
+		static bool generate_flush_vals(Tables& t);
+
+	private:
+		static Tables const* s_tables;
+	};
+
+}
+
+
+#endif
+
@@ -5,11 +5,15 @@
 
 #include "poker_hand_value.hpp"
 #include "poker_hand_eval_tables.hpp"
+#include "holdem_hand_eval.hpp"
+#include "omaha_hand_eval.hpp"
 
 #include "poker_core/cardset.hpp"
 #include "poker_core/hand.hpp"
 #include "poker_core/board.hpp"
 
+#include <cassert>
+
 namespace epw {
 
 	struct PokerHandEval
@@ -206,59 +210,21 @@ namespace epw {
 
 	namespace holdem {
 
+		/*! Uses the direct lookup evaluator, which requires HoldemHandEval::initialize() to have been called (asserted in debug builds) */
 		inline HandVal evaluate_hand(Hand const& h, Board const& b)
 		{
-			Cardset cards;
-			for(size_t c = 0; c < CARDS_PER_HAND; ++c)
-			{
-				cards.insert(h[c]);
-			}
-			for(size_t c = 0; c < b.count; ++c)
-			{
-				cards.insert(b[c]);
-			}
-
-			return PokerHandEval::EvaluateHandFtr<>() (cards, CARDS_PER_HAND + b.count);
+			assert(HoldemHandEval::is_initialized() && "HoldemHandEval::initialize() not called");
+			return HoldemHandEval::evaluate(h, b);
 		}
 
 	}
 
 	namespace omaha {
 
+		/*! Uses the direct lookup evaluator, which requires OmahaHandEval::initialize() to have been called */
 		inline HandVal evaluate_hand(Hand const& h, Board const& b)
 		{
-			Cardset cards;
-			HandVal best = HandVal::NOTHING;
-			for(size_t h1 = 0; h1 < CARDS_PER_HAND - 1; ++h1)
-			{
-				cards.insert(h[h1]);
-				for(size_t h2 = h1 + 1; h2 < CARDS_PER_HAND; ++h2)
-				{
-					cards.insert(h[h2]);
-					for(size_t b1 = 0; b1 < b.count - 2; ++b1)
-					{
-						cards.insert(b[b1]);
-						for(size_t b2 = b1 + 1; b2 < b.count - 1; ++b2)
-						{
-							cards.insert(b[b2]);
-							for(size_t b3 = b2 + 1; b3 < b.count; ++b3)
-							{
-								cards.insert(b[b3]);
-
-								HandVal val = PokerHandEval::EvaluateHandFtr<>() (cards, 5);
-								best = std::max(best, val);
-
-								cards.remove(b[b3]);
-							}
-							cards.remove(b[b2]);
-						}
-						cards.remove(b[b1]);
-					}
-					cards.remove(h[h2]);
-				}
-				cards.remove(h[h1]);
-			}
-			return best;
+			return OmahaHandEval::evaluate(h, b);
 		}
 
 	}
@@ -0,0 +1,482 @@
+// poker_hand_eval_batch.cpp
+
+#include "poker_hand_eval_batch.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define EPW_BATCH_EVAL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define EPW_TARGET_AVX2
+#else
+#define EPW_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#include "gen_util/xoshiro.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+
+namespace epw {
+
+	namespace {
+
+		// Layout of the 64 bit mask underlying a Cardset, which the vectorized implementation loads directly
+		uint32_t const CARDSET_SUIT_WIDTH = 16;
+		uint32_t const CARDSET_RANK_MASK = 0x1fff;
+
+		bool cardset_layout_matches()
+		{
+			for(size_t c = 0; c < FULL_DECK_SIZE; ++c)
+			{
+				Card const card((card_t)c);
+				uint64_t mask;
+				std::memcpy(&mask, &Cardset::from_card(card), sizeof(mask));
+				if(mask != (uint64_t)1 << (CARDSET_SUIT_WIDTH * card.get_suit() + card.get_rank()))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+	}
+
+	PokerHandEvalBatch::Tables const* PokerHandEvalBatch::s_tables = nullptr;
+	PokerHandEvalBatch::Implementation PokerHandEvalBatch::s_impl = PokerHandEvalBatch::Scalar;
+
+	bool PokerHandEvalBatch::initialize()
+	{
+		// Storage for the tables when built rather than mapped, allocated on first use
+		static std::unique_ptr< Tables > generated(new Tables());
+
+		Tables& t = *generated;
+		for(uint32_t rs = 0; rs < RANKSET_COUNT; ++rs)
+		{
+			t.packed_rank_tables[rs] =
+				(uint32_t)nBitsTable[rs] |
+				((uint32_t)straightTable[rs] << 8) |
+				((uint32_t)topCardTable[rs] << 16);
+		}
+
+		return initialize(t);
+	}
+
+	bool PokerHandEvalBatch::initialize(Tables const& tables)
+	{
+		s_tables = &tables;
+		select_implementation();
+		return true;
+	}
+
+	void PokerHandEvalBatch::select_implementation()
+	{
+		s_impl = Scalar;
+		if(cpu_supports_avx2() && cardset_layout_matches())
+		{
+			bool const avx2_ok = self_check(AVX2, SELF_CHECK_SAMPLES);
+			assert(avx2_ok && "Vectorized evaluation does not match EvaluateHandFtr");
+			s_impl = avx2_ok ? AVX2 : Scalar;
+		}
+	}
+
+	bool PokerHandEvalBatch::set_implementation(Implementation impl)
+	{
+		if(impl == AVX2 && !(s_tables != nullptr && cpu_supports_avx2() && cardset_layout_matches()))
+		{
+			return false;
+		}
+
+		s_impl = impl;
+		return true;
+	}
+
+	bool PokerHandEvalBatch::self_check(Implementation impl, size_t const random_samples, bool const exhaustive)
+	{
+		Implementation const prev_impl = s_impl;
+		if(!set_implementation(impl))
+		{
+			return false;
+		}
+
+		bool ok = true;
+		std::vector< Cardset > cards;
+		if(exhaustive)
+		{
+			cards.reserve(combinations::ct< FULL_DECK_SIZE, 5 >::res);
+			for(size_t c1 = 0; c1 < FULL_DECK_SIZE; ++c1)
+			for(size_t c2 = c1 + 1; c2 < FULL_DECK_SIZE; ++c2)
+			for(size_t c3 = c2 + 1; c3 < FULL_DECK_SIZE; ++c3)
+			for(size_t c4 = c3 + 1; c4 < FULL_DECK_SIZE; ++c4)
+			for(size_t c5 = c4 + 1; c5 < FULL_DECK_SIZE; ++c5)
+			{
+				Cardset cs;
+				cs.insert(Card((card_t)c1));
+				cs.insert(Card((card_t)c2));
+				cs.insert(Card((card_t)c3));
+				cs.insert(Card((card_t)c4));
+				cs.insert(Card((card_t)c5));
+				cards.push_back(cs);
+			}
+			ok = matches_scalar(cards, 5);
+		}
+
+		// Fixed seed, so that any failure is reproducible
+		xoshiro256starstar gen;
+		for(int n_cards = 5; ok && n_cards <= 7; ++n_cards)
+		{
+			cards.assign(random_samples, Cardset());
+			for(size_t i = 0; i < random_samples; ++i)
+			{
+				// Partial shuffle of the deck
+				std::array< card_t, FULL_DECK_SIZE > deck;
+				for(size_t c = 0; c < FULL_DECK_SIZE; ++c)
+				{
+					deck[c] = (card_t)c;
+				}
+				for(int c = 0; c < n_cards; ++c)
+				{
+					std::swap(deck[c], deck[c + (size_t)rand_below(gen, FULL_DECK_SIZE - c)]);
+					cards[i].insert(Card(deck[c]));
+				}
+			}
+			ok = matches_scalar(cards, n_cards);
+		}
+
+		s_impl = prev_impl;
+		return ok;
+	}
+
+	bool PokerHandEvalBatch::matches_scalar(std::vector< Cardset > const& cards, int const n_cards)
+	{
+		std::vector< HandVal > results(cards.size());
+		std::vector< HandVal > expected(cards.size());
+		for(int fc = PokerHandEval::ClubFlushPossible; fc <= PokerHandEval::NoFlushPossible; ++fc)
+		{
+			PokerHandEval::FlushCondition const flush_cond = (PokerHandEval::FlushCondition)fc;
+			evaluate(cards.data(), cards.size(), n_cards, results.data(), flush_cond);
+			evaluate_scalar(cards.data(), cards.size(), n_cards, expected.data(), flush_cond);
+			if(results != expected)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool PokerHandEvalBatch::cpu_supports_avx2()
+	{
+#if defined(EPW_BATCH_EVAL_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if(info[0] < 7)
+		{
+			return false;
+		}
+
+		// OS must be saving the YMM registers
+		__cpuid(info, 1);
+		bool const osxsave = (info[2] & (1 << 27)) != 0;
+		if(!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(EPW_BATCH_EVAL_X86)
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#else
+		return false;
+#endif
+	}
+
+	void PokerHandEvalBatch::evaluate(
+		Cardset const cards[],
+		size_t const count,
+		int const n_cards,
+		HandVal results[],
+		PokerHandEval::FlushCondition const flush_cond
+		)
+	{
+		size_t const vec_count = s_impl == AVX2 ? count - count % SIMD_WIDTH : 0;
+		if(vec_count > 0)
+		{
+			evaluate_avx2(cards, vec_count, n_cards, results, flush_cond);
+		}
+		evaluate_scalar(cards + vec_count, count - vec_count, n_cards, results + vec_count, flush_cond);
+	}
+
+	void PokerHandEvalBatch::evaluate_scalar(Cardset const cards[], size_t const count, int const n_cards, HandVal results[], PokerHandEval::FlushCondition const flush_cond)
+	{
+		switch(flush_cond)
+		{
+		case PokerHandEval::ClubFlushPossible:
+			for(size_t i = 0; i < count; ++i)
+			{
+				results[i] = PokerHandEval::EvaluateHandFtr< PokerHandEval::ClubFlushPossible >()(cards[i], n_cards);
+			}
+			break;
+		case PokerHandEval::DiamondFlushPossible:
+			for(size_t i = 0; i < count; ++i)
+			{
+				results[i] = PokerHandEval::EvaluateHandFtr< PokerHandEval::DiamondFlushPossible >()(cards[i], n_cards);
+			}
+			break;
+		case PokerHandEval::HeartFlushPossible:
+			for(size_t i = 0; i < count; ++i)
+			{
+				results[i] = PokerHandEval::EvaluateHandFtr< PokerHandEval::HeartFlushPossible >()(cards[i], n_cards);
+			}
+			break;
+		case PokerHandEval::SpadeFlushPossible:
+			for(size_t i = 0; i < count; ++i)
+			{
+				results[i] = PokerHandEval::EvaluateHandFtr< PokerHandEval::SpadeFlushPossible >()(cards[i], n_cards);
+			}
+			break;
+		case PokerHandEval::AnyFlushPossible:
+			for(size_t i = 0; i < count; ++i)
+			{
+				results[i] = PokerHandEval::EvaluateHandFtr< PokerHandEval::AnyFlushPossible >()(cards[i], n_cards);
+			}
+			break;
+		case PokerHandEval::NoFlushPossible:
+			for(size_t i = 0; i < count; ++i)
+			{
+				results[i] = PokerHandEval::EvaluateHandFtr< PokerHandEval::NoFlushPossible >()(cards[i], n_cards);
+			}
+			break;
+		}
+	}
+
+
+#if defined(EPW_BATCH_EVAL_X86)
+
+	namespace {
+
+		static_assert(sizeof(Cardset) == sizeof(uint64_t), "Vectorized evaluation loads Cardsets directly as 64 bit masks");
+		static_assert(sizeof(HandVal) == sizeof(uint32_t), "Vectorized evaluation stores HandVals directly as 32 bit values");
+
+		EPW_TARGET_AVX2 inline __m256i gather(uint32_t const* table, __m256i const idx)
+		{
+			return _mm256_i32gather_epi32(reinterpret_cast< int const* >(table), idx, 4);
+		}
+
+		EPW_TARGET_AVX2 inline __m256i n_bits(__m256i const packed)
+		{
+			return _mm256_and_si256(packed, _mm256_set1_epi32(0xff));
+		}
+
+		EPW_TARGET_AVX2 inline __m256i straight_top(__m256i const packed)
+		{
+			return _mm256_and_si256(_mm256_srli_epi32(packed, 8), _mm256_set1_epi32(0xff));
+		}
+
+		EPW_TARGET_AVX2 inline __m256i top_card(__m256i const packed)
+		{
+			return _mm256_srli_epi32(packed, 16);
+		}
+
+		EPW_TARGET_AVX2 inline __m256i bit(__m256i const r)
+		{
+			return _mm256_sllv_epi32(_mm256_set1_epi32(1), r);
+		}
+
+		EPW_TARGET_AVX2 inline __m256i select(__m256i const mask, __m256i const if_true, __m256i const if_false)
+		{
+			return _mm256_blendv_epi8(if_false, if_true, mask);
+		}
+
+		EPW_TARGET_AVX2 inline __m256i is_zero(__m256i const v)
+		{
+			return _mm256_cmpeq_epi32(v, _mm256_setzero_si256());
+		}
+
+		EPW_TARGET_AVX2 inline __m256i hand_type(HandVal::HandType const ht)
+		{
+			return _mm256_set1_epi32((int)HandVal::make_hand_type(ht));
+		}
+
+		EPW_TARGET_AVX2 inline __m256i card_value(__m256i const r, int const shift)
+		{
+			return _mm256_slli_epi32(r, shift);
+		}
+
+	}
+
+	EPW_TARGET_AVX2 void PokerHandEvalBatch::evaluate_avx2(Cardset const cards[], size_t const count, int const n_cards, HandVal results[], PokerHandEval::FlushCondition const flush_cond)
+	{
+		uint32_t const* const packed = s_tables->packed_rank_tables;
+		uint32_t const* const top_five = reinterpret_cast< uint32_t const* >(topFiveCardsTable);
+
+		__m256i const rank_mask = _mm256_set1_epi32((int)CARDSET_RANK_MASK);
+		__m256i const four = _mm256_set1_epi32(4);
+		__m256i const two = _mm256_set1_epi32(2);
+		__m256i const one = _mm256_set1_epi32(1);
+		__m256i const cards_in_hand = _mm256_set1_epi32(n_cards);
+		// Selects the low 32 bits of each 64 bit mask into the low half, and high 32 bits into the high half
+		__m256i const deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+		for(size_t i = 0; i < count; i += SIMD_WIDTH)
+		{
+			__m256i const lo = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast< __m256i const* >(cards + i)), deinterleave);
+			__m256i const hi = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast< __m256i const* >(cards + i + 4)), deinterleave);
+			__m256i const cd = _mm256_permute2x128_si256(lo, hi, 0x20);
+			__m256i const hs = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+			__m256i suits[Card::SUIT_COUNT];
+			suits[Card::CLUBS] = _mm256_and_si256(cd, rank_mask);
+			suits[Card::DIAMONDS] = _mm256_and_si256(_mm256_srli_epi32(cd, CARDSET_SUIT_WIDTH), rank_mask);
+			suits[Card::HEARTS] = _mm256_and_si256(hs, rank_mask);
+			suits[Card::SPADES] = _mm256_and_si256(_mm256_srli_epi32(hs, CARDSET_SUIT_WIDTH), rank_mask);
+			__m256i const& sc = suits[Card::CLUBS];
+			__m256i const& sd = suits[Card::DIAMONDS];
+			__m256i const& sh = suits[Card::HEARTS];
+			__m256i const& ss = suits[Card::SPADES];
+
+			__m256i const ranks = _mm256_or_si256(_mm256_or_si256(sc, sd), _mm256_or_si256(sh, ss));
+			__m256i const p_ranks = gather(packed, ranks);
+			__m256i const n_ranks = n_bits(p_ranks);
+			__m256i const n_dups = _mm256_sub_epi32(cards_in_hand, n_ranks);
+			__m256i const five_ranks = _mm256_cmpgt_epi32(n_ranks, four);
+
+			// Straight, flush, or straight flush
+			__m256i retval = _mm256_setzero_si256();
+			__m256i sf_found = _mm256_setzero_si256();
+			if(flush_cond != PokerHandEval::NoFlushPossible && _mm256_movemask_epi8(five_ranks))
+			{
+				for(size_t s = 0; s < Card::SUIT_COUNT; ++s)
+				{
+					if(flush_cond != PokerHandEval::AnyFlushPossible && flush_cond != (PokerHandEval::FlushCondition)s)
+					{
+						continue;
+					}
+
+					__m256i const p_suit = gather(packed, suits[s]);
+					__m256i const is_flush = _mm256_andnot_si256(sf_found, _mm256_cmpgt_epi32(n_bits(p_suit), four));
+					if(!_mm256_movemask_epi8(is_flush))
+					{
+						continue;
+					}
+
+					__m256i const st = straight_top(p_suit);
+					__m256i const is_sf = _mm256_andnot_si256(is_zero(st), is_flush);
+					__m256i const flush_val = _mm256_or_si256(hand_type(HandVal::FLUSH), gather(top_five, suits[s]));
+					__m256i const sf_val = _mm256_or_si256(hand_type(HandVal::STRAIGHTFLUSH), card_value(st, HandVal::TOP_CARD_SHIFT));
+					retval = select(is_flush, select(is_sf, sf_val, flush_val), retval);
+					sf_found = _mm256_or_si256(sf_found, is_sf);
+				}
+			}
+
+			{
+				__m256i const st = straight_top(p_ranks);
+				__m256i const is_straight = _mm256_and_si256(_mm256_and_si256(five_ranks, is_zero(retval)), _mm256_andnot_si256(is_zero(st), _mm256_set1_epi32(-1)));
+				retval = select(is_straight, _mm256_or_si256(hand_type(HandVal::STRAIGHT), card_value(st, HandVal::TOP_CARD_SHIFT)), retval);
+			}
+
+			// Lanes whose result is already known: straight flushes, and made five card hands when no full house/quads is possible
+			__m256i const done = _mm256_or_si256(sf_found,
+				_mm256_andnot_si256(is_zero(retval), _mm256_and_si256(five_ranks, _mm256_cmpgt_epi32(_mm256_set1_epi32(3), n_dups))));
+
+			__m256i const two_mask = _mm256_xor_si256(ranks, _mm256_xor_si256(_mm256_xor_si256(sc, sd), _mm256_xor_si256(sh, ss)));
+			__m256i const p_two = gather(packed, two_mask);
+			__m256i const three_mask = _mm256_and_si256(
+				_mm256_or_si256(_mm256_and_si256(sc, sd), _mm256_and_si256(sh, ss)),
+				_mm256_or_si256(_mm256_and_si256(sc, sh), _mm256_and_si256(sd, ss))
+				);
+
+			__m256i const dups_1 = _mm256_cmpeq_epi32(n_dups, one);
+			__m256i const dups_2 = _mm256_cmpeq_epi32(n_dups, two);
+			__m256i const dups_3plus = _mm256_cmpgt_epi32(n_dups, two);
+
+			// No pair
+			__m256i res = gather(top_five, ranks);
+
+			// One pair
+			if(_mm256_movemask_epi8(dups_1))
+			{
+				__m256i const t = _mm256_xor_si256(ranks, two_mask);
+				__m256i const kickers = _mm256_andnot_si256(_mm256_set1_epi32(HandVal::FIFTH_CARD_MASK), _mm256_srli_epi32(gather(top_five, t), HandVal::CARD_WIDTH));
+				__m256i const val = _mm256_or_si256(_mm256_or_si256(hand_type(HandVal::ONEPAIR), card_value(top_card(p_two), HandVal::TOP_CARD_SHIFT)), kickers);
+				res = select(dups_1, val, res);
+			}
+
+			// Two pair or trips
+			if(_mm256_movemask_epi8(dups_2))
+			{
+				__m256i const t = _mm256_xor_si256(ranks, two_mask);
+				__m256i const two_pair_val = _mm256_or_si256(_mm256_or_si256(
+					hand_type(HandVal::TWOPAIR),
+					_mm256_and_si256(gather(top_five, two_mask), _mm256_set1_epi32(HandVal::TOP_CARD_MASK | HandVal::SECOND_CARD_MASK))),
+					card_value(top_card(gather(packed, t)), HandVal::THIRD_CARD_SHIFT)
+					);
+
+				__m256i const t3 = _mm256_xor_si256(ranks, three_mask);
+				__m256i const second = top_card(gather(packed, t3));
+				__m256i const trips_val = _mm256_or_si256(
+					_mm256_or_si256(hand_type(HandVal::TRIPS), card_value(top_card(gather(packed, three_mask)), HandVal::TOP_CARD_SHIFT)),
+					_mm256_or_si256(card_value(second, HandVal::SECOND_CARD_SHIFT), card_value(top_card(gather(packed, _mm256_xor_si256(t3, bit(second)))), HandVal::THIRD_CARD_SHIFT))
+					);
+
+				res = select(dups_2, select(is_zero(two_mask), trips_val, two_pair_val), res);
+			}
+
+			// Quads, full house, straight/flush, or two pair
+			if(_mm256_movemask_epi8(dups_3plus))
+			{
+				__m256i const four_mask = _mm256_and_si256(_mm256_and_si256(sc, sd), _mm256_and_si256(sh, ss));
+				__m256i const tc4 = top_card(gather(packed, four_mask));
+				__m256i const quads_val = _mm256_or_si256(
+					_mm256_or_si256(hand_type(HandVal::QUADS), card_value(tc4, HandVal::TOP_CARD_SHIFT)),
+					card_value(top_card(gather(packed, _mm256_xor_si256(ranks, bit(tc4)))), HandVal::SECOND_CARD_SHIFT)
+					);
+
+				__m256i const tc3 = top_card(gather(packed, three_mask));
+				__m256i const fh_val = _mm256_or_si256(
+					_mm256_or_si256(hand_type(HandVal::FULLHOUSE), card_value(tc3, HandVal::TOP_CARD_SHIFT)),
+					card_value(top_card(gather(packed, _mm256_xor_si256(_mm256_or_si256(two_mask, three_mask), bit(tc3)))), HandVal::SECOND_CARD_SHIFT)
+					);
+				__m256i const is_fh = _mm256_xor_si256(_mm256_cmpeq_epi32(n_bits(p_two), n_dups), _mm256_set1_epi32(-1));
+
+				// Matches HandVal::two_pair(), which encodes its hand type as NOPAIR
+				__m256i const top = top_card(p_two);
+				__m256i const second = top_card(gather(packed, _mm256_xor_si256(two_mask, bit(top))));
+				__m256i const two_pair_val = _mm256_or_si256(
+					_mm256_or_si256(card_value(top, HandVal::TOP_CARD_SHIFT), card_value(second, HandVal::SECOND_CARD_SHIFT)),
+					card_value(top_card(gather(packed, _mm256_xor_si256(_mm256_xor_si256(ranks, bit(top)), bit(second)))), HandVal::THIRD_CARD_SHIFT)
+					);
+
+				__m256i const val =
+					select(is_zero(four_mask),
+						select(is_fh,
+							fh_val,
+							select(is_zero(retval), two_pair_val, retval)
+							),
+						quads_val
+						);
+				res = select(dups_3plus, val, res);
+			}
+
+			res = select(done, retval, res);
+			_mm256_storeu_si256(reinterpret_cast< __m256i* >(results + i), res);
+		}
+	}
+
+#else
+
+	void PokerHandEvalBatch::evaluate_avx2(Cardset const cards[], size_t const count, int const n_cards, HandVal results[], PokerHandEval::FlushCondition const flush_cond)
+	{
+		evaluate_scalar(cards, count, n_cards, results, flush_cond);
+	}
+
+#endif
+
+}
+
@@ -0,0 +1,103 @@
+// poker_hand_eval_batch.hpp
+/*!
+Batched evaluation of many cardsets in a single call. Where the CPU supports AVX2 (detected at runtime), cardsets are evaluated 8 at
+a time, with every branch of PokerHandEval::EvaluateHandFtr computed for all lanes using table gathers and then the applicable
+result selected per lane. Otherwise, and for any remainder, each cardset is passed to EvaluateHandFtr. Results are identical to
+EvaluateHandFtr in either case.
+*/
+
+#ifndef EPW_POKER_HAND_EVAL_BATCH_H
+#define EPW_POKER_HAND_EVAL_BATCH_H
+
+#include "poker_hand_eval.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace epw {
+
+	class PokerHandEvalBatch
+	{
+	public:
+		enum Implementation {
+			Scalar,
+			AVX2,
+		};
+
+		enum {
+			SIMD_WIDTH = 8,
+			RANKSET_COUNT = 1 << Card::RANK_COUNT,
+			SELF_CHECK_SAMPLES = 4096,		// Random cardsets of each size checked by initialize()
+		};
+
+		/*! The widened tables, as a single block so that LookupTables can write it to and map it from a blob file */
+		struct Tables
+		{
+			/*! nBitsTable, straightTable and topCardTable packed into bits 0-7, 8-15 and 16-23 of a single 32 bit gatherable entry */
+			uint32_t	packed_rank_tables[RANKSET_COUNT];
+		};
+
+	public:
+		/*!
+		Builds the widened tables used by the vectorized implementation and selects the best implementation for this CPU. The
+		vectorized implementation is only selected if it passes self_check() on SELF_CHECK_SAMPLES random cardsets of each size.
+		*/
+		static bool initialize();
+
+		/*! As above, but using tables which were built elsewhere, such as mapped from a file, and which must remain valid while in use */
+		static bool initialize(Tables const& tables);
+
+		/*! The tables in use, or null if not initialized */
+		static inline Tables const* get_tables()
+		{
+			return s_tables;
+		}
+
+		static inline Implementation get_implementation()
+		{
+			return s_impl;
+		}
+
+		/*! Forces a given implementation. Returns false if it is not supported by this CPU, or needs tables not yet initialized. */
+		static bool set_implementation(Implementation impl);
+
+		/*!
+		Checks that evaluate() with the given implementation matches PokerHandEval::EvaluateHandFtr under every flush condition, on
+		random_samples random cardsets of each of 5, 6 and 7 cards, and additionally on every 5 card set if exhaustive. Returns false
+		on any mismatch, or if the implementation is not supported. The current implementation is left unchanged.
+		*/
+		static bool self_check(Implementation impl, size_t const random_samples, bool const exhaustive = false);
+
+		/*!
+		Evaluates count cardsets, each consisting of n_cards cards, into results. flush_cond has the same meaning as the FlushSuit
+		template parameter of PokerHandEval::EvaluateHandFtr, and applies to every cardset in the batch.
+		*/
+		static void evaluate(
+			Cardset const cards[],
+			size_t const count,
+			int const n_cards,
+			HandVal results[],
+			PokerHandEval::FlushCondition const flush_cond = PokerHandEval::AnyFlushPossible
+			);
+
+	private:
+		static void evaluate_scalar(Cardset const cards[], size_t const count, int const n_cards, HandVal results[], PokerHandEval::FlushCondition const flush_cond);
+		static void evaluate_avx2(Cardset const cards[], size_t const count, int const n_cards, HandVal results[], PokerHandEval::FlushCondition const flush_cond);
+
+		static bool cpu_supports_avx2();
+		static void select_implementation();
+
+		/*! Compares evaluate() with evaluate_scalar() on the given cardsets, under every flush condition */
+		static bool matches_scalar(std::vector< Cardset > const& cards, int const n_cards);
+
+	private:
+		static Tables const* s_tables;
+		static Implementation s_impl;
+	};
+
+}
+
+
+#endif
+
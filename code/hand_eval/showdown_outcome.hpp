@@ -251,6 +251,14 @@ namespace epw
 			counts[oc] += amt;
 		}
 
+		inline void combine_with(const array_showdown_outcomes& other)
+		{
+			for(size_t i = 0; i < ArraySize; ++i)
+			{
+				counts[i] += other.counts[i];
+			}
+		}
+
 		typedef typename map_type::const_iterator		const_iterator;
 
 		const_iterator begin() const
@@ -317,6 +325,14 @@ namespace epw {
 			counts[oc] += amt;
 		}
 
+		inline void combine_with(const hashed_showdown_outcomes& other)
+		{
+			for(auto const& entry: other.counts)
+			{
+				counts[entry.first] += entry.second;
+			}
+		}
+
 		typedef typename map_type::const_iterator		const_iterator;
 
 		const_iterator begin() const
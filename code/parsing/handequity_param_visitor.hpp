@@ -36,6 +36,63 @@ namespace epw {
 			return true;
 		}
 
+		bool operator() (ast::target_err_param_t const& target)
+		{
+			if(target.target_err <= 0.0)
+			{
+				return false;
+			}
+
+			sim_desc.target_std_err = target.target_err / 100.0;
+			return true;
+		}
+
+		bool operator() (ast::time_param_t const& time)
+		{
+			sim_desc.time_limit_ms = time.ms;
+			return true;
+		}
+
+		bool operator() (ast::seed_param_t const& seed)
+		{
+			sim_desc.seed = seed.seed;
+			return true;
+		}
+
+		bool operator() (ast::enumerate_param_t const& enumerate)
+		{
+			sim_desc.enumeration = enumerate.mode;
+			return true;
+		}
+
+		bool operator() (ast::breakdown_param_t const& breakdown)
+		{
+			if(is_variant_type< string >(breakdown.player))
+			{
+				string alias = get_variant_as< string >(breakdown.player);
+				auto map_entry = alias_map.find(alias);
+				if(map_entry == alias_map.end())
+				{
+					// No player with this alias
+					return false;
+				}
+				sim_desc.breakdown_player = map_entry->second;
+			}
+			else if(is_variant_type< HandPosition >(breakdown.player))
+			{
+				HandPosition pos = get_variant_as< HandPosition >(breakdown.player);
+				auto map_entry = position_map.find(pos);
+				if(map_entry == position_map.end())
+				{
+					// No known player at this position
+					return false;
+				}
+				sim_desc.breakdown_player = map_entry->second;
+			}
+
+			return (bool)sim_desc.breakdown_player;
+		}
+
 		sim::HandEquitySimDesc& sim_desc;
 		std::map< string, size_t > const& alias_map;
 		std::map< HandPosition, size_t > const& position_map;
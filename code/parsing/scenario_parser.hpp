@@ -12,6 +12,7 @@
 #include "subrangecount_param_visitor.hpp"
 #include "handtypecount_param_visitor.hpp"
 #include "handequity_param_visitor.hpp"
+#include "stackequity_param_visitor.hpp"
 
 #include "gen_util/variant_type_access.hpp"
 #include "simulation/sim_scenario.hpp"
@@ -263,6 +264,11 @@ namespace epw {
 							return false;
 						}
 					}
+
+					if(!desc.is_valid())
+					{
+						return false;
+					}
 					
 					sims.push_back(desc);
 					return true;
@@ -280,6 +286,11 @@ namespace epw {
 						}
 					}
 
+					if(!desc.is_valid())
+					{
+						return false;
+					}
+
 					sims.push_back(desc);
 					return true;
 				}
@@ -287,6 +298,20 @@ namespace epw {
 				inline bool operator() (ast::stackequity_sim_t const& s)
 				{
 					sim::StackEquitySimDesc desc;
+					for(ast::stackequity_sim_param_t const& param: s)
+					{
+						stackequity_param_visitor param_visitor(desc, alias_map, position_map);
+						if(!boost::apply_visitor(param_visitor, param))
+						{
+							return false;
+						}
+					}
+
+					if(!desc.is_valid())
+					{
+						return false;
+					}
+
 					sims.push_back(desc);
 					return true;
 				}
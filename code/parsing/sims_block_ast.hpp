@@ -7,6 +7,7 @@
 
 #include "poker_core/composite_card_match.hpp"
 #include "poker_core/flopgame.hpp"
+#include "simulation/simulation_modes.hpp"
 
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
@@ -29,6 +30,43 @@ namespace scenario {
 		uint32_t num_samples;
 	};
 
+	struct target_err_param_t
+	{
+		target_err_param_t(double _e = 0.0): target_err(_e)
+		{}
+
+		double target_err;		// Percent
+	};
+
+	struct time_param_t
+	{
+		time_param_t(uint32_t _ms = 0): ms(_ms)
+		{}
+
+		uint32_t ms;
+	};
+
+	struct seed_param_t
+	{
+		seed_param_t(uint64_t _s = 0): seed(_s)
+		{}
+
+		uint64_t seed;
+	};
+
+	struct enumerate_param_t
+	{
+		enumerate_param_t(sim::EnumerationMode _m = sim::NO_ENUMERATION): mode(_m)
+		{}
+
+		sim::EnumerationMode mode;
+	};
+
+	struct breakdown_param_t
+	{
+		player_id_t		player;
+	};
+
 	struct player_subranges_t
 	{
 		player_id_t							player;
@@ -39,7 +77,10 @@ namespace scenario {
 
 	typedef boost::variant<
 		subranges_param_t,
-		samples_param_t
+		samples_param_t,
+		target_err_param_t,
+		time_param_t,
+		seed_param_t
 	> subrangecount_sim_param_t;
 
 	typedef std::vector< subrangecount_sim_param_t > subrangecount_sim_t;
@@ -54,19 +95,35 @@ namespace scenario {
 
 	typedef boost::variant<
 		samples_param_t,
-		street_param_t
+		street_param_t,
+		enumerate_param_t,
+		target_err_param_t,
+		time_param_t,
+		seed_param_t
 	> handtypecount_sim_param_t;
 
 	typedef std::vector< handtypecount_sim_param_t > handtypecount_sim_t;
 
 	typedef boost::variant<
-		samples_param_t
+		samples_param_t,
+		enumerate_param_t,
+		target_err_param_t,
+		time_param_t,
+		seed_param_t,
+		breakdown_param_t
 	> handequity_sim_param_t;
 
 	typedef std::vector< handequity_sim_param_t > handequity_sim_t;
 
-	struct stackequity_sim_t
-	{};
+	typedef boost::variant<
+		samples_param_t,
+		enumerate_param_t,
+		target_err_param_t,
+		time_param_t,
+		seed_param_t
+	> stackequity_sim_param_t;
+
+	typedef std::vector< stackequity_sim_param_t > stackequity_sim_t;
 
 	struct simulation_t
 	{
@@ -101,6 +158,31 @@ BOOST_FUSION_ADAPT_STRUCT(
 	(uint32_t, num_samples)
 )
 
+BOOST_FUSION_ADAPT_STRUCT(
+    epw::_ast::scenario::target_err_param_t,
+	(double, target_err)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    epw::_ast::scenario::time_param_t,
+	(uint32_t, ms)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    epw::_ast::scenario::seed_param_t,
+	(uint64_t, seed)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    epw::_ast::scenario::enumerate_param_t,
+	(epw::sim::EnumerationMode, mode)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+    epw::_ast::scenario::breakdown_param_t,
+	(epw::_ast::scenario::player_id_t, player)
+)
+
 BOOST_FUSION_ADAPT_STRUCT(
     epw::_ast::scenario::player_subranges_t,
     (epw::_ast::scenario::player_id_t, player)
@@ -112,10 +194,6 @@ BOOST_FUSION_ADAPT_STRUCT(
 	(epw::flopgame::Street, st)
 )
 
-BOOST_FUSION_ADAPT_STRUCT(
-    epw::_ast::scenario::stackequity_sim_t,
-)
-
 BOOST_FUSION_ADAPT_STRUCT(
     epw::_ast::scenario::simulation_t,
     (boost::optional< epw::string >, name)
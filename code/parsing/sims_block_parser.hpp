@@ -31,6 +31,7 @@ namespace epw {
 			using qi::char_;
 			using qi::double_;
 			using qi::uint_;
+			using qi::ulong_long;
 			using qi::repeat;
 			using qi::eol;
 			using qi::eoi;
@@ -61,6 +62,35 @@ namespace epw {
 				lit("street") >> "=" >> betting_street
 				;
 
+			// Target standard error of the sim's estimates, in percent
+			target_err_param = 
+				lit("target_err") >> "=" >> double_
+				;
+
+			// Time limit in milliseconds. Unless a sample count is also given, the sim runs for all of this time
+			time_param = 
+				lit("time") >> "=" >> uint_
+				;
+
+			seed_param = 
+				lit("seed") >> "=" >> ulong_long
+				;
+
+			enumeration_modes.add
+				("none", sim::NO_ENUMERATION)
+				("runouts", sim::ENUMERATE_RUNOUTS)
+				("all", sim::ENUMERATE_ALL)
+				;
+
+			enumerate_param = 
+				lit("enumerate") >> "=" >> enumeration_modes
+				;
+
+			// Player whose range's equity is broken down by hand
+			breakdown_param = 
+				lit("breakdown") >> "=" >> '@' >> player_id
+				;
+
 			subrange_list =
 				range % ';'
 				;
@@ -76,6 +106,9 @@ namespace epw {
 			subrangecount_sim_param =
 				subranges_param
 				| samples_param
+				| target_err_param
+				| time_param
+				| seed_param
 				;
 
 			subrangecount_sim =
@@ -86,6 +119,10 @@ namespace epw {
 			handtypecount_sim_param =
 				samples_param
 				| street_param
+				| enumerate_param
+				| target_err_param
+				| time_param
+				| seed_param
 				;
 
 			handtypecount_sim =
@@ -95,6 +132,11 @@ namespace epw {
 
 			handequity_sim_param =
 				samples_param
+				| enumerate_param
+				| target_err_param
+				| time_param
+				| seed_param
+				| breakdown_param
 				;
 
 			handequity_sim =
@@ -102,8 +144,17 @@ namespace epw {
 				handequity_sim_param % ','
 				;
 
+			stackequity_sim_param =
+				samples_param
+				| enumerate_param
+				| target_err_param
+				| time_param
+				| seed_param
+				;
+
 			stackequity_sim =
-				eps [ _val = phx::construct< ast::stackequity_sim_t >() ]
+				':' >>
+				stackequity_sim_param % ','
 				;
 
 			simulation =
@@ -162,6 +213,30 @@ namespace epw {
 			street_param
 			;
 
+		qi::rule< Iterator, ast::target_err_param_t(), scenario_skipper< Iterator > >
+			target_err_param
+			;
+
+		qi::rule< Iterator, ast::time_param_t(), scenario_skipper< Iterator > >
+			time_param
+			;
+
+		qi::rule< Iterator, ast::seed_param_t(), scenario_skipper< Iterator > >
+			seed_param
+			;
+
+		qi::symbols< char, sim::EnumerationMode >
+			enumeration_modes
+			;
+
+		qi::rule< Iterator, ast::enumerate_param_t(), scenario_skipper< Iterator > >
+			enumerate_param
+			;
+
+		qi::rule< Iterator, ast::breakdown_param_t(), scenario_skipper< Iterator > >
+			breakdown_param
+			;
+
 		qi::rule< Iterator, std::vector< cmatch::CardMatch >(), scenario_skipper< Iterator > >
 			subrange_list
 			;
@@ -198,6 +273,10 @@ namespace epw {
 			handequity_sim
 			;
 
+		qi::rule< Iterator, ast::stackequity_sim_param_t(), scenario_skipper< Iterator > >
+			stackequity_sim_param
+			;
+
 		qi::rule< Iterator, ast::stackequity_sim_t(), scenario_skipper< Iterator > >
 			stackequity_sim
 			;
@@ -0,0 +1,76 @@
+// stackequity_param_visitor.hpp
+
+#ifndef EPW_STACKEQUITY_PARAM_VISITOR_H
+#define EPW_STACKEQUITY_PARAM_VISITOR_H
+
+#include "sims_block_ast.hpp"
+
+#include "simulation/sim_scenario.hpp"
+
+#include "gen_util/variant_type_access.hpp"
+
+#include <boost/variant/static_visitor.hpp>
+
+
+namespace epw {
+
+	namespace {
+		namespace ast = epw::_ast::scenario;
+	}
+
+	struct stackequity_param_visitor: public boost::static_visitor< bool >
+	{
+		stackequity_param_visitor(
+			sim::StackEquitySimDesc& _desc,
+			std::map< string, size_t > const& _alias_map,
+			std::map< HandPosition, size_t > const& _position_map
+			):
+			sim_desc(_desc),
+			alias_map(_alias_map),
+			position_map(_position_map)
+		{}
+
+		bool operator() (ast::samples_param_t const& samples)
+		{
+			sim_desc.num_samples = samples.num_samples;
+			return true;
+		}
+
+		bool operator() (ast::target_err_param_t const& target)
+		{
+			if(target.target_err <= 0.0)
+			{
+				return false;
+			}
+
+			sim_desc.target_std_err = target.target_err / 100.0;
+			return true;
+		}
+
+		bool operator() (ast::time_param_t const& time)
+		{
+			sim_desc.time_limit_ms = time.ms;
+			return true;
+		}
+
+		bool operator() (ast::seed_param_t const& seed)
+		{
+			sim_desc.seed = seed.seed;
+			return true;
+		}
+
+		bool operator() (ast::enumerate_param_t const& enumerate)
+		{
+			sim_desc.enumeration = enumerate.mode;
+			return true;
+		}
+
+		sim::StackEquitySimDesc& sim_desc;
+		std::map< string, size_t > const& alias_map;
+		std::map< HandPosition, size_t > const& position_map;
+	};
+
+}
+
+
+#endif
@@ -77,6 +77,29 @@ namespace epw {
 			return true;
 		}
 
+		bool operator() (ast::target_err_param_t const& target)
+		{
+			if(target.target_err <= 0.0)
+			{
+				return false;
+			}
+
+			sim_desc.target_std_err = target.target_err / 100.0;
+			return true;
+		}
+
+		bool operator() (ast::time_param_t const& time)
+		{
+			sim_desc.time_limit_ms = time.ms;
+			return true;
+		}
+
+		bool operator() (ast::seed_param_t const& seed)
+		{
+			sim_desc.seed = seed.seed;
+			return true;
+		}
+
 		sim::SubrangeCountSimDesc& sim_desc;
 		std::map< string, size_t > const& alias_map;
 		std::map< HandPosition, size_t > const& position_map;
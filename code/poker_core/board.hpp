@@ -48,6 +48,14 @@ namespace epw {
 			}
 		}
 
+		/*! Remove the most recently added card. */
+		void remove_last()
+		{
+			assert(count > 0);
+
+			--count;
+		}
+
 		/*! Reset to an empty board. For speed purposes does not bother to reset the individual cards to have null values. */
 		void reset()
 		{
@@ -6,6 +6,8 @@
 #include "cards.hpp"
 #include "rankset.hpp"
 
+#include "gen_util/bit_ops.hpp"
+
 #include <boost/range/iterator_range.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 
@@ -30,6 +32,12 @@ namespace epw {
 			return CARD_MASKS[c.get_index()];
 		}
 
+		/*! The cards of the given ranks in a single suit */
+		static inline Cardset from_rankset(Rankset const rs, Card::suit_t const suit)
+		{
+			return Cardset((uint64_t)(Rankset::storage_t)rs << (SUIT_WIDTH * suit));
+		}
+
 	private:
 		explicit Cardset(uint64_t mask): cards(mask)
 		{}
@@ -126,6 +134,16 @@ namespace epw {
 			return contains_any(from_card(c));
 		}
 
+		inline bool operator== (Cardset const& cs) const
+		{
+			return cards == cs.cards;
+		}
+
+		inline bool operator!= (Cardset const& cs) const
+		{
+			return cards != cs.cards;
+		}
+
 		/* Reset to a fulldeck. */
 		void set_full()
 		{
@@ -137,6 +155,24 @@ namespace epw {
 			return cards == 0ull;
 		}
 
+		/* Number of cards in the set. */
+		inline size_t size() const
+		{
+			return popcount(cards);
+		}
+
+		/* Writes the cards in the set to out, which must have space for size() cards. Returns the number of cards written. */
+		inline size_t get_cards(Card out[]) const
+		{
+			size_t count = 0;
+			for(uint64_t rem = cards; rem != 0; rem = clear_lowest_bit(rem))
+			{
+				size_t const bit = lowest_bit_index(rem);
+				out[count++] = Card((Card::rank_t)(bit % SUIT_WIDTH), (Card::suit_t)(bit / SUIT_WIDTH));
+			}
+			return count;
+		}
+
 		inline Cardset complement() const
 		{
 			return Cardset(~cards) & FULL_DECK;
@@ -7,6 +7,7 @@
 
 #include <boost/dynamic_bitset.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -99,6 +100,45 @@ namespace flopgame {
 		Status m_state;
 	};
 
+	/*! One of the pots formed when players are all in for different amounts */
+	struct SidePot {
+		/*! The size of this pot */
+		PotState::pot_size_t m_size;
+
+		/*! Which players are eligible to win this pot */
+		boost::dynamic_bitset<> m_eligible;
+	};
+
+	/*! Splits the total contributions of each player into the main pot followed by any side pots. Each pot is contested by
+	 * every player who contributed at least the pot's level, so a contribution which nobody else matched forms a pot with a
+	 * single eligible player, and is returned to them.
+	 */
+	inline std::vector< SidePot > build_side_pots(PotState::stack_array_t const& contribs) {
+		PotState::stack_array_t levels;
+		for(PotState::pot_size_t const c: contribs) {
+			if(c > 0)
+				levels.push_back(c);
+		}
+		std::sort(levels.begin(), levels.end());
+		levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+
+		std::vector< SidePot > pots;
+		PotState::pot_size_t prev_level = 0;
+		for(PotState::pot_size_t const level: levels) {
+			SidePot pot;
+			pot.m_size = 0;
+			pot.m_eligible.resize(contribs.size());
+			for(size_t p = 0; p < contribs.size(); ++p) {
+				pot.m_size += std::min(contribs[p], level) - std::min(contribs[p], prev_level);
+				if(contribs[p] >= level)
+					pot.m_eligible.set(p);
+			}
+			pots.push_back(pot);
+			prev_level = level;
+		}
+		return pots;
+	}
+
 }
 }// end namespaces
 
@@ -0,0 +1,225 @@
+// suit_isomorphism.hpp
+/*!
+Canonicalization of cards under permutation of the suits. Relabelling the suits of every card in a situation never changes the
+outcome of any evaluation, so situations which are suit permutations of each other need only be evaluated once, weighted by the
+number of such permutations.
+
+An ordered sequence of cardsets (for example a board followed by each player's hand) is canonicalized jointly: each suit is given a
+key made up of its ranks in each of the cardsets in turn, and suits are relabelled in decreasing order of key. Two sequences are
+then suit permutations of one another exactly when their canonical forms are equal.
+*/
+
+#ifndef EPW_SUIT_ISOMORPHISM_H
+#define EPW_SUIT_ISOMORPHISM_H
+
+#include "cards.hpp"
+#include "cardset.hpp"
+#include "board.hpp"
+
+#include "gen_util/combinatorics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+
+namespace epw {
+namespace suit_iso {
+
+	enum {
+		NUM_SUIT_PERMUTATIONS = fact::ct< Card::SUIT_COUNT >::res,		// 24
+		MAX_SETS = 16,		// Max cardsets in a jointly canonicalized sequence
+	};
+
+	/*! Maps each suit to the suit it is relabelled as */
+	typedef std::array< Card::suit_t, Card::SUIT_COUNT > permutation_t;
+
+	inline permutation_t identity()
+	{
+		return all_suits;
+	}
+
+	inline permutation_t inverse(permutation_t const& perm)
+	{
+		permutation_t inv;
+		for(size_t s = 0; s < Card::SUIT_COUNT; ++s)
+		{
+			inv[perm[s]] = (Card::suit_t)s;
+		}
+		return inv;
+	}
+
+	inline Card permute(permutation_t const& perm, Card const& c)
+	{
+		return Card(c.get_rank(), perm[c.get_suit()]);
+	}
+
+	inline Cardset permute(permutation_t const& perm, Cardset const& cs)
+	{
+		Cardset res;
+		for(size_t s = 0; s < Card::SUIT_COUNT; ++s)
+		{
+			res |= Cardset::from_rankset(cs.get_rankset((Card::suit_t)s), perm[s]);
+		}
+		return res;
+	}
+
+	/*! Order of the board cards is preserved */
+	inline Board permute(permutation_t const& perm, Board const& b)
+	{
+		Board res;
+		for(Card const& c: b)
+		{
+			res.add(permute(perm, c));
+		}
+		return res;
+	}
+
+	struct CanonicalForm
+	{
+		permutation_t	perm;			// Maps the original suits onto the canonical ones
+		size_t			stabilizer;		// Number of suit permutations leaving the sequence unchanged
+		size_t			weight;			// Number of distinct sequences which are suit permutations of this one
+
+		CanonicalForm(): perm(identity()), stabilizer(NUM_SUIT_PERMUTATIONS), weight(1)
+		{}
+	};
+
+	/*! Canonicalizes a sequence of count cardsets jointly, writing the canonical sequence to out (which may be the same as sets) */
+	inline CanonicalForm canonicalize(Cardset const sets[], size_t const count, Cardset out[])
+	{
+		assert(count <= MAX_SETS);
+
+		typedef std::array< Rankset::storage_t, MAX_SETS > key_t;
+
+		std::array< key_t, Card::SUIT_COUNT > keys = {};
+		for(size_t s = 0; s < Card::SUIT_COUNT; ++s)
+		{
+			for(size_t i = 0; i < count; ++i)
+			{
+				keys[s][i] = sets[i].get_rankset((Card::suit_t)s);
+			}
+		}
+
+		permutation_t order = identity();
+		std::stable_sort(order.begin(), order.end(), [&keys](Card::suit_t const a, Card::suit_t const b)
+		{
+			return keys[a] > keys[b];
+		});
+
+		CanonicalForm cf;
+		cf.stabilizer = 1;
+		size_t run = 1;
+		for(size_t i = 0; i < Card::SUIT_COUNT; ++i)
+		{
+			cf.perm[order[i]] = (Card::suit_t)i;
+
+			// Suits with equal keys can be exchanged freely
+			if(i > 0 && keys[order[i]] == keys[order[i - 1]])
+			{
+				cf.stabilizer *= ++run;
+			}
+			else
+			{
+				run = 1;
+			}
+		}
+		cf.weight = NUM_SUIT_PERMUTATIONS / cf.stabilizer;
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			out[i] = permute(cf.perm, sets[i]);
+		}
+		return cf;
+	}
+
+	/*! Canonicalizes a single cardset, such as a board, in place */
+	inline CanonicalForm canonicalize(Cardset& cs)
+	{
+		return canonicalize(&cs, 1, &cs);
+	}
+
+	/*! Canonicalizes a hand and board jointly, in place */
+	inline CanonicalForm canonicalize(Cardset& hand, Cardset& board)
+	{
+		std::array< Cardset, 2 > sets = { hand, board };
+		CanonicalForm const cf = canonicalize(sets.data(), sets.size(), sets.data());
+		hand = sets[0];
+		board = sets[1];
+		return cf;
+	}
+
+	/*! Number of suit permutations leaving every one of the sequence of cardsets unchanged */
+	inline size_t stabilizer(Cardset const sets[], size_t const count)
+	{
+		std::array< Cardset, MAX_SETS > canonical;
+		return canonicalize(sets, count, canonical.data()).stabilizer;
+	}
+
+	namespace detail {
+
+		template < typename Ftr >
+		void enumerate_subsets(
+			Card const live[], size_t const num_live, size_t const start, size_t const remaining,
+			Cardset const subset, Cardset seq[], size_t const count, size_t const fixed_stabilizer,
+			permutation_t const& to_orig, Ftr& ftr)
+		{
+			if(remaining == 0)
+			{
+				// No symmetry, so every subset is a class of its own
+				if(fixed_stabilizer == 1)
+				{
+					ftr(permute(to_orig, subset), 1);
+					return;
+				}
+
+				seq[count - 1] = subset;
+				std::array< Cardset, MAX_SETS > canonical;
+				CanonicalForm const cf = canonicalize(seq, count, canonical.data());
+
+				// The fixed sets are already canonical, so are unchanged, and only the representative of each class maps to itself
+				if(canonical[count - 1] == subset)
+				{
+					ftr(permute(to_orig, subset), fixed_stabilizer / cf.stabilizer);
+				}
+				return;
+			}
+
+			for(size_t i = start; i + remaining <= num_live; ++i)
+			{
+				Cardset next = subset;
+				next.insert(live[i]);
+				enumerate_subsets(live, num_live, i + 1, remaining - 1, next, seq, count, fixed_stabilizer, to_orig, ftr);
+			}
+		}
+
+	}
+
+	/*!
+	Calls ftr(subset, weight) once for each class of k card subsets of live, where two subsets are in the same class if some suit
+	permutation leaving every one of the fixed cardsets unchanged maps one to the other. weight is the number of subsets in the class,
+	so the weights sum to (size of live choose k). live must itself be unchanged by any such permutation, which is the case if it is
+	the remaining deck after removing all of the fixed cards, or the full deck.
+	*/
+	template < typename Ftr >
+	void enumerate_canonical_subsets(Cardset const live, size_t const k, Cardset const fixed[], size_t const num_fixed, Ftr ftr)
+	{
+		assert(num_fixed < MAX_SETS);
+
+		// Work in the frame in which the fixed sets are canonical
+		std::array< Cardset, MAX_SETS > seq;
+		CanonicalForm const fixed_cf = canonicalize(fixed, num_fixed, seq.data());
+		Cardset const live_c = permute(fixed_cf.perm, live);
+
+		std::array< Card, FULL_DECK_SIZE > cards;
+		size_t const num_live = live_c.get_cards(cards.data());
+
+		detail::enumerate_subsets(cards.data(), num_live, 0, k, Cardset(), seq.data(), num_fixed + 1, fixed_cf.stabilizer, inverse(fixed_cf.perm), ftr);
+	}
+
+}
+}
+
+
+#endif
+
@@ -6,6 +6,8 @@
 #include "sim_spec_base.hpp"
 #include "poker_core/cardset.hpp"
 
+#include <cstdint>
+
 
 namespace epw {
 namespace sim {
@@ -13,13 +15,23 @@ namespace sim {
 	class BasicSimSpec: public SimSpecBase
 	{
 	public:
+		BasicSimSpec(): m_seed(0)
+		{}
+
 		inline Cardset const& get_initially_blocked() const
 		{
 			return m_initially_blocked;
 		}
 
+		/*! Seed shared by all cores' random streams */
+		inline uint64_t get_seed() const
+		{
+			return m_seed;
+		}
+
 	public:
 		Cardset m_initially_blocked;
+		uint64_t m_seed;
 	};
 
 }
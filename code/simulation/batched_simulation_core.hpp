@@ -0,0 +1,217 @@
+// batched_simulation_core.hpp
+
+#ifndef EPW_BATCHED_SIMULATION_CORE_H
+#define EPW_BATCHED_SIMULATION_CORE_H
+
+#include "simulation_core.hpp"
+#include "sim_board_gen.hpp"
+
+#include "poker_core/cardset.hpp"
+#include "poker_core/board.hpp"
+#include "hand_eval/showdown_outcome.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+
+namespace epw {
+namespace sim {
+
+	/*!
+	Structure of arrays storage for a block of generated paths, each consisting of a hand for every player (as an index into the
+	player's range) and a complete board.
+	*/
+	struct PathBatch
+	{
+		size_t						capacity;
+		size_t						num_players;
+		size_t						count;			// Number of paths currently stored
+
+		std::vector< uint32_t >		hands;			// [player * capacity + path]
+		std::vector< Board >		boards;			// [path]
+
+		PathBatch(): capacity(0), num_players(0), count(0)
+		{}
+
+		void initialize(size_t const _num_players, size_t const _capacity)
+		{
+			capacity = _capacity;
+			num_players = _num_players;
+			count = 0;
+			hands.assign(num_players * capacity, 0);
+			boards.assign(capacity, Board());
+		}
+
+		inline uint32_t const* player_hands(size_t const player) const
+		{
+			return &hands[player * capacity];
+		}
+
+		inline uint32_t* player_hands(size_t const player)
+		{
+			return &hands[player * capacity];
+		}
+	};
+
+	/*!
+	Minimal path state used while filling a PathBatch. Only records what the batch needs, so generating a path involves none of the
+	per component copying of the hand and board access policies.
+	*/
+	struct BatchPathState
+	{
+		Cardset										deck;
+		std::array< uint32_t, MaxPlayersDealtIn >	hands;
+		Board									board;
+
+		template < typename SimSpec >
+		void initialize(SimSpec const& spec)
+		{
+			board = spec.m_initial_board;
+			deck = Cardset::FULL_DECK;
+			deck.remove(board.begin(), board.end());
+		}
+
+		template < typename SimSpec >
+		inline void on_initialize_player_hand(size_t const player, size_t const index, SimSpec const& spec)
+		{
+			hands[player] = static_cast< uint32_t >(index);
+		}
+
+		inline void on_board_card(Card const& c)
+		{
+			board.add(c);
+		}
+
+		/*! Undoes on_board_card() for the most recently added card */
+		inline void on_remove_board_card(Card const& c)
+		{
+			assert(board[board.count - 1] == c);
+			board.remove_last();
+		}
+	};
+
+	/*!
+	A simulation core which separates path generation from evaluation. Each block of up to BatchSize samples is first generated in
+	full, with the path generator and a random runout, into a PathBatch, and then passed as a whole to the batch traverser's
+	traverse_batch(). The random number generation and deck bookkeeping, and the evaluation, each then run as a tight loop over the
+	block, and the traverser is free to evaluate stage by stage across all paths, vectorizing or prefetching as it sees fit.
+
+	Provides the same interface as SimulationCore. BatchTraversal must provide board_cards_needed() in addition.
+	*/
+	template <
+		typename SimSpec,
+		typename SimContext,
+		typename PathGen,
+		typename BatchTraversal,
+		size_t BatchSize = 1024
+	>
+	class BatchedSimulationCore
+	{
+	public:
+		typedef SimSpec									sim_spec_t;
+
+	private:
+		typedef SimContext								sim_context_t;
+		typedef BatchPathState							path_state_t;
+		typedef PathGen									path_gen_t;
+		typedef BatchTraversal							batch_traversal_t;
+
+	public:
+		typedef typename batch_traversal_t::results_t	results_t;
+
+		enum {
+			INCREMENTAL = true,		// Each call to run() adds further samples to the results
+			PARTITIONED = false,	// Every core runs the same simulation independently
+		};
+
+	public:
+		BatchedSimulationCore(sim_spec_t const& _sim_spec): m_sim_spec(_sim_spec)
+		{}
+
+		/*! One-time core initialization. core_index identifies this core amongst those running the same simulation. */
+		void initialize(size_t core_index = 0)
+		{
+			m_context.initialize(m_sim_spec, core_index);
+			m_path_generator.initialize(m_sim_spec);
+			m_batch_traverser.initialize(m_sim_spec);
+			m_batch.initialize(m_sim_spec.get_num_players(), BatchSize);
+		}
+
+		/*! Runs num_samples. Assumes initialize() has been called already */
+		void run(sample_count_t const num_samples)
+		{
+			path_state_t initial_path_state;
+			initial_path_state.initialize(m_sim_spec);
+
+			size_t const board_cards_needed = batch_traversal_t::board_cards_needed(m_sim_spec);
+
+			sample_count_t done = 0;
+			while(done < num_samples)
+			{
+				size_t const count = (size_t)std::min< sample_count_t >(BatchSize, num_samples - done);
+				generate_batch(initial_path_state, board_cards_needed, count);
+
+				m_batch_traverser.traverse_batch(
+					m_sim_spec,
+					m_context,
+					m_batch
+					);
+
+				done += count;
+			}
+		}
+
+		void get_results(results_t& res) const
+		{
+			m_batch_traverser.get_results(res);
+		}
+
+	private:
+		void generate_batch(path_state_t const& initial_path_state, size_t const board_cards_needed, size_t const count)
+		{
+			size_t const num_players = m_sim_spec.get_num_players();
+			for(size_t k = 0; k < count; ++k)
+			{
+				path_state_t path_state(initial_path_state);
+
+				m_path_generator.generate_path(
+					m_sim_spec,
+					m_context,
+					path_state
+					);
+
+				LiveDeckBoardGen::runout_board(board_cards_needed, m_context, path_state);
+
+				for(size_t p = 0; p < num_players; ++p)
+				{
+					m_batch.player_hands(p)[k] = path_state.hands[p];
+				}
+				m_batch.boards[k] = path_state.board;
+			}
+
+			m_batch.count = count;
+		}
+
+	private:
+		/*! Reference to the unchanging simulation specification */
+		sim_spec_t const& m_sim_spec;
+
+		sim_context_t m_context;
+
+		path_gen_t m_path_generator;
+
+		batch_traversal_t m_batch_traverser;
+
+		/*! Storage for the block of paths currently being processed */
+		PathBatch m_batch;
+	};
+
+}
+}
+
+
+#endif
+
@@ -0,0 +1,565 @@
+// blocker_aware_path_gen.hpp
+
+#ifndef EPW_BLOCKER_AWARE_PATH_GEN_H
+#define EPW_BLOCKER_AWARE_PATH_GEN_H
+
+#include "range_tuple_path_gen.hpp"
+
+#include "poker_core/cardset.hpp"
+#include "gen_util/bit_ops.hpp"
+#include "gen_util/xoshiro.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+namespace epw {
+namespace sim {
+
+	/*!
+	The data used by BlockerAware_PathGen, which depends only on the ranges and the initially blocked cards. Built once per
+	simulation by the spec (see MultipleRange_SimSpec::localize_hand_data()), and shared read only by every core's path generator.
+
+	Players' hands are drawn in order of increasing range size, each only from the hands in the player's range that are compatible
+	with the cards already dealt. Every player's set of compatible hands is kept up to date as each hand is dealt, by removing the
+	hands containing its cards using precomputed per card exclusion bitsets, and the tuple is restarted as soon as any player is left
+	with none. Drawing a hand uniformly from the n_i compatible hands, with n_i depending on the earlier draws, would bias the tuple
+	distribution, so instead an index is drawn from [0, M_i), where M_i is a fixed upper bound on n_i, and the tuple is restarted if
+	the index is not less than n_i. Every valid tuple is then generated with probability 1 / prod(M_i), so sampling is exactly
+	uniform over valid tuples.
+
+	M_i is the number of hands in the player's range less a lower bound on the number ruled out by the union of the hands of all
+	players drawn earlier. The lower bound is the largest of: the number ruled out by any single earlier player's hand, or by any pair
+	of earlier players' hands, minimized over their possible hands (counted exactly where affordable, otherwise bounded using per card
+	hand counts); and the sum over earlier players of the minimum total per card hand count of their hands, divided by the number of
+	cards in a hand, since the earlier hands are disjoint and each hand in the range is counted at most once per card.
+
+	A pilot run of each method estimates its cost per accepted tuple, in units of one independent hand draw, and the cheaper method
+	is used. A blocker aware hand draw costs DRAW_COST_PERCENT hundredths of a unit, and an update of one word of a compatible hand
+	set WORD_COST_PERCENT, as measured relative to each other. The pilot is deterministic, so the choice, and hence the sampled paths
+	for a given seed, are reproducible.
+	*/
+	class BlockerAware_SharedData
+	{
+	public:
+		enum {
+			PILOT_TRIALS = 4096,
+			DRAW_COST_PERCENT = 250,
+			WORD_COST_PERCENT = 75,
+			EXACT_BOUND_MAX_WORK = 1 << 26,		// Max words processed per player or pair of players when calculating exact bounds
+			EXACT_BOUND_MAX_STORED = 1 << 20,	// Max words of ruled out hand sets kept per earlier player for the pair bounds
+		};
+
+		/*! Per core working storage for the compatible hand sets */
+		struct scratch_t
+		{
+			std::vector< uint64_t >		valid;			// [player * max_words + word]
+			std::vector< size_t >		num_valid;		// [player]
+		};
+
+	protected:
+		struct range_data
+		{
+			size_t							num_words;
+			std::vector< uint64_t >			base;			// Hands not blocked by the initially blocked cards
+			std::vector< uint64_t >			excl;			// For each card, the hands containing it ([card * num_words + word])
+			size_t							base_count;		// Number of hands in base
+			std::array< size_t, FULL_DECK_SIZE >	card_counts;	// For each card, the number of hands in base containing it
+			size_t							max_hand_cards;	// Most cards in any hand
+			std::vector< uint8_t >			hand_cards;		// For each hand, the indices of its cards ([hand * max_hand_cards + card])
+			size_t							bound;			// Upper bound on the number of compatible hands given earlier players' hands
+		};
+
+		struct earlier_player
+		{
+			bool						exact;			// Whether the hands each of masks rules out are counted exactly
+			bool						stored;			// Whether they are also kept in excluded, for the pair bounds
+			std::vector< Cardset >		masks;			// Hands not blocked by the initially blocked cards
+			std::vector< uint64_t >		excluded;		// If stored, for each of masks, the hands of the later player's base it rules out
+		};
+
+	public:
+		BlockerAware_SharedData(): m_use_naive(true), m_max_words(0)
+		{}
+
+		template < typename SimSpec >
+		void build(SimSpec const& spec)
+		{
+			m_range_data.clear();
+			m_draw_order.clear();
+			m_max_words = 0;
+
+			uint64_t naive_cost = 0;
+			size_t const naive_accepted = naive_pilot(spec, naive_cost);
+			if(naive_accepted > 0 && naive_cost * 100 <= min_accepted_work(spec) * naive_accepted)
+			{
+				// Independent draws already cost no more than the blocker aware method possibly could, so there is no need to build it
+				m_use_naive = true;
+				return;
+			}
+
+			build_range_data(spec);
+			build_bounds(spec);
+
+			scratch_t scratch;
+			initialize_scratch(scratch);
+			xoshiro256starstar gen;
+			uint64_t work = 0;
+			size_t accepted = 0;
+			for(size_t t = 0; t < PILOT_TRIALS; ++t)
+			{
+				if(attempt(spec, gen, scratch, [](size_t, size_t) {}, work))
+				{
+					++accepted;
+				}
+			}
+
+			// Compare naive_cost / naive_accepted with work / accepted, in hundredths of a hand draw
+			m_use_naive = accepted == 0 || naive_cost * 100 * accepted <= work * naive_accepted;
+		}
+
+		inline bool use_naive() const
+		{
+			return m_use_naive;
+		}
+
+		void initialize_scratch(scratch_t& scratch) const
+		{
+			scratch.valid.assign(m_range_data.size() * m_max_words, 0);
+			scratch.num_valid.assign(m_range_data.size(), 0);
+		}
+
+		/*!
+		Makes one attempt at drawing a hand tuple, calling on_hand(player, hand_index) for each hand drawn. Returns false if the
+		tuple was rejected, in which case some of the players' hands may have been drawn already. work is incremented by the cost
+		of the attempt, as above.
+		*/
+		template < typename SimSpec, typename Gen, typename OnHand >
+		bool attempt(SimSpec const& spec, Gen& gen, scratch_t& scratch, OnHand on_hand, uint64_t& work) const
+		{
+			size_t const num_players = m_draw_order.size();
+			for(size_t d = 0; d < num_players; ++d)
+			{
+				size_t const i = m_draw_order[d];
+				range_data const& rd = m_range_data[i];
+
+				// The first player's compatible hands are those in base, later ones have been updated as each hand was dealt
+				uint64_t const* const valid = d == 0 ? rd.base.data() : &scratch.valid[i * m_max_words];
+				size_t const num_valid = d == 0 ? rd.base_count : scratch.num_valid[i];
+				assert(num_valid <= rd.bound);
+
+				work += DRAW_COST_PERCENT;
+				size_t const sel = (size_t)rand_below(gen, rd.bound);
+				if(sel >= num_valid)
+				{
+					return false;
+				}
+
+				size_t const sel_hand = select_valid(valid, rd.num_words, sel);
+				on_hand(i, sel_hand);
+
+				if(d + 1 == num_players)
+				{
+					break;
+				}
+
+				uint8_t const* const cards = &rd.hand_cards[sel_hand * rd.max_hand_cards];
+				for(size_t e = d + 1; e < num_players; ++e)
+				{
+					size_t const j = m_draw_order[e];
+					range_data const& rj = m_range_data[j];
+					uint64_t const* const src = d == 0 ? rj.base.data() : &scratch.valid[j * m_max_words];
+					uint64_t* const dst = &scratch.valid[j * m_max_words];
+					size_t count = 0;
+					for(size_t w = 0; w < rj.num_words; ++w)
+					{
+						uint64_t word = src[w];
+						for(size_t c = 0; c < rd.max_hand_cards; ++c)
+						{
+							word &= ~rj.excl[cards[c] * rj.num_words + w];
+						}
+						dst[w] = word;
+						count += popcount(word);
+					}
+					work += rj.num_words * WORD_COST_PERCENT;
+
+					if(count == 0)
+					{
+						// This tuple can no longer be completed
+						return false;
+					}
+					scratch.num_valid[j] = count;
+				}
+			}
+			return true;
+		}
+
+	protected:
+		/*! Runs the pilot for independent draws. Returns the number of tuples accepted, and sets cost to the number of hands drawn. */
+		template < typename SimSpec >
+		static size_t naive_pilot(SimSpec const& spec, uint64_t& cost)
+		{
+			xoshiro256starstar gen;
+			size_t accepted = 0;
+			size_t const num_players = spec.get_num_players();
+			cost = 0;
+			for(size_t t = 0; t < PILOT_TRIALS; ++t)
+			{
+				Cardset blocked = spec.get_initially_blocked();
+				size_t i = 0;
+				for(; i < num_players; ++i)
+				{
+					++cost;
+					Cardset const hand_mask = spec.get_hand_data< Hand_Mask >(i, (size_t)rand_below(gen, spec.get_player_range_size(i)));
+					if(hand_mask.contains_any(blocked))
+					{
+						break;
+					}
+					blocked |= hand_mask;
+				}
+
+				if(i == num_players)
+				{
+					++accepted;
+				}
+			}
+			return accepted;
+		}
+
+		/*!
+		A lower bound on the work of an accepted blocker aware attempt, which draws every player's hand and updates the compatible
+		hands of every player yet to be drawn after each one. Assumes the players with the most words are drawn first.
+		*/
+		template < typename SimSpec >
+		static uint64_t min_accepted_work(SimSpec const& spec)
+		{
+			size_t const num_players = spec.get_num_players();
+			std::vector< size_t > words(num_players);
+			for(size_t i = 0; i < num_players; ++i)
+			{
+				words[i] = (spec.get_player_range_size(i) + 63) / 64;
+			}
+			std::sort(words.begin(), words.end(), [](size_t const a, size_t const b) { return a > b; });
+
+			uint64_t work = 0;
+			for(size_t d = 0; d < num_players; ++d)
+			{
+				work += DRAW_COST_PERCENT + d * words[d] * WORD_COST_PERCENT;
+			}
+			return work;
+		}
+
+		template < typename SimSpec >
+		void build_range_data(SimSpec const& spec)
+		{
+			size_t const num_players = spec.get_num_players();
+			Cardset const initially_blocked = spec.get_initially_blocked();
+
+			m_range_data.resize(num_players);
+			for(size_t i = 0; i < num_players; ++i)
+			{
+				range_data& rd = m_range_data[i];
+				size_t const range_size = spec.get_player_range_size(i);
+				rd.num_words = (range_size + 63) / 64;
+				rd.base.assign(rd.num_words, 0);
+				rd.excl.assign(FULL_DECK_SIZE * rd.num_words, 0);
+				rd.base_count = 0;
+				rd.card_counts.fill(0);
+				rd.max_hand_cards = 1;
+				for(size_t h = 0; h < range_size; ++h)
+				{
+					rd.max_hand_cards = std::max(rd.max_hand_cards, spec.get_hand_data< Hand_Mask >(i, h).size());
+				}
+				rd.hand_cards.assign(range_size * rd.max_hand_cards, 0);
+
+				for(size_t h = 0; h < range_size; ++h)
+				{
+					uint64_t const bit = (uint64_t)1 << (h % 64);
+					Cardset const hand_mask = spec.get_hand_data< Hand_Mask >(i, h);
+					Card cards[FULL_DECK_SIZE];
+					size_t const num_cards = hand_mask.get_cards(cards);
+					for(size_t c = 0; c < rd.max_hand_cards; ++c)
+					{
+						// Hands with fewer cards repeat their first, which is harmless when removing the hands containing them
+						rd.hand_cards[h * rd.max_hand_cards + c] = (uint8_t)cards[c < num_cards ? c : 0].get_index();
+					}
+					for(size_t c = 0; c < num_cards; ++c)
+					{
+						rd.excl[cards[c].get_index() * rd.num_words + h / 64] |= bit;
+					}
+
+					if(!hand_mask.contains_any(initially_blocked))
+					{
+						rd.base[h / 64] |= bit;
+						++rd.base_count;
+						for(size_t c = 0; c < num_cards; ++c)
+						{
+							++rd.card_counts[cards[c].get_index()];
+						}
+					}
+				}
+
+				m_max_words = std::max(m_max_words, rd.num_words);
+			}
+
+			// Drawing the most constrained players first keeps the bounds for the later, wider ranges tight
+			m_draw_order.resize(num_players);
+			for(size_t i = 0; i < num_players; ++i)
+			{
+				m_draw_order[i] = i;
+			}
+			std::stable_sort(m_draw_order.begin(), m_draw_order.end(), [this](size_t const a, size_t const b)
+			{
+				return m_range_data[a].base_count < m_range_data[b].base_count;
+			});
+		}
+
+		/*! Sets each player's bound, M_i, as described above */
+		template < typename SimSpec >
+		void build_bounds(SimSpec const& spec)
+		{
+			size_t const num_players = m_draw_order.size();
+			for(size_t d = 0; d < num_players; ++d)
+			{
+				size_t const i = m_draw_order[d];
+				range_data& rd = m_range_data[i];
+
+				// For each earlier player, their hands and, when affordable, the number of hands of i's range each of them rules out
+				std::vector< earlier_player > earlier(d);
+				for(size_t e = 0; e < d; ++e)
+				{
+					range_data const& rj = m_range_data[m_draw_order[e]];
+					earlier[e].exact = rj.base_count * rd.num_words <= EXACT_BOUND_MAX_WORK;
+					earlier[e].stored = false;
+				}
+
+				// The ruled out hand sets are only kept for players in at least one pair whose exact bound is affordable
+				for(size_t e = 0; e < d; ++e)
+				{
+					for(size_t f = e + 1; f < d; ++f)
+					{
+						if(pair_affordable(m_range_data[m_draw_order[e]], m_range_data[m_draw_order[f]], rd))
+						{
+							earlier[e].stored = earlier[f].stored = true;
+						}
+					}
+				}
+
+				size_t min_excluded = 0;
+				size_t card_count_sum = 0;
+				std::vector< uint64_t > excl_words(rd.num_words);
+				for(size_t e = 0; e < d; ++e)
+				{
+					size_t const j = m_draw_order[e];
+					range_data const& rj = m_range_data[j];
+					earlier_player& ep = earlier[e];
+					if(ep.stored)
+					{
+						ep.excluded.reserve(rj.base_count * rd.num_words);
+					}
+
+					size_t min_for_j = rd.base_count;
+					size_t min_count_sum = std::numeric_limits< size_t >::max();
+					for(size_t h = 0; h < spec.get_player_range_size(j); ++h)
+					{
+						if((rj.base[h / 64] & ((uint64_t)1 << (h % 64))) == 0)
+						{
+							continue;
+						}
+
+						Cardset const hand_mask = spec.get_hand_data< Hand_Mask >(j, h);
+						Card cards[FULL_DECK_SIZE];
+						size_t const num_cards = hand_mask.get_cards(cards);
+						ep.masks.push_back(hand_mask);
+
+						size_t count_sum = 0;
+						size_t count_max = 0;
+						for(size_t c = 0; c < num_cards; ++c)
+						{
+							size_t const count = rd.card_counts[cards[c].get_index()];
+							count_sum += count;
+							count_max = std::max(count_max, count);
+						}
+						min_count_sum = std::min(min_count_sum, count_sum);
+
+						size_t excluded = count_max;
+						if(ep.exact)
+						{
+							excluded = 0;
+							for(size_t w = 0; w < rd.num_words; ++w)
+							{
+								uint64_t word = 0;
+								for(size_t c = 0; c < num_cards; ++c)
+								{
+									word |= rd.excl[cards[c].get_index() * rd.num_words + w];
+								}
+								excl_words[w] = word & rd.base[w];
+								excluded += popcount(excl_words[w]);
+							}
+
+							if(ep.stored)
+							{
+								ep.excluded.insert(ep.excluded.end(), excl_words.begin(), excl_words.end());
+							}
+						}
+						min_for_j = std::min(min_for_j, excluded);
+					}
+
+					if(!ep.masks.empty())
+					{
+						min_excluded = std::max(min_excluded, min_for_j);
+						card_count_sum += min_count_sum;
+					}
+				}
+
+				for(size_t e = 0; e < d; ++e)
+				{
+					for(size_t f = e + 1; f < d; ++f)
+					{
+						size_t pair_excluded = 0;
+						if(exact_pair_excluded(earlier[e], earlier[f], rd, pair_excluded))
+						{
+							min_excluded = std::max(min_excluded, pair_excluded);
+						}
+					}
+				}
+
+				min_excluded = std::max(min_excluded, (card_count_sum + rd.max_hand_cards - 1) / rd.max_hand_cards);
+				min_excluded = std::min(min_excluded, rd.base_count);
+				rd.bound = std::max< size_t >(rd.base_count - min_excluded, 1);
+			}
+		}
+
+		/*!
+		Whether the exact bound for a pair of earlier players with ranges ra and rb is affordable for rd, both in the work of
+		comparing every pair of their hands and in the memory needed to keep the hands each of them rules out
+		*/
+		static inline bool pair_affordable(range_data const& ra, range_data const& rb, range_data const& rd)
+		{
+			return
+				ra.base_count * rb.base_count * rd.num_words <= EXACT_BOUND_MAX_WORK &&
+				ra.base_count * rd.num_words <= EXACT_BOUND_MAX_STORED &&
+				rb.base_count * rd.num_words <= EXACT_BOUND_MAX_STORED;
+		}
+
+		/*!
+		Finds the minimum number of hands of rd's base ruled out by a compatible pair of hands of the two earlier players. Returns
+		false if this is not affordable, or no such pair exists.
+		*/
+		static bool exact_pair_excluded(earlier_player const& a, earlier_player const& b, range_data const& rd, size_t& result)
+		{
+			if(!a.stored || !b.stored || a.masks.size() * b.masks.size() * rd.num_words > EXACT_BOUND_MAX_WORK)
+			{
+				return false;
+			}
+
+			bool any = false;
+			result = rd.base_count;
+			for(size_t ha = 0; ha < a.masks.size(); ++ha)
+			{
+				uint64_t const* const excl_a = &a.excluded[ha * rd.num_words];
+				for(size_t hb = 0; hb < b.masks.size(); ++hb)
+				{
+					if(a.masks[ha].contains_any(b.masks[hb]))
+					{
+						continue;
+					}
+
+					uint64_t const* const excl_b = &b.excluded[hb * rd.num_words];
+					size_t excluded = 0;
+					for(size_t w = 0; w < rd.num_words; ++w)
+					{
+						excluded += popcount(excl_a[w] | excl_b[w]);
+					}
+					result = std::min(result, excluded);
+					any = true;
+				}
+			}
+			return any;
+		}
+
+		static inline size_t select_valid(uint64_t const* valid, size_t const num_words, size_t sel)
+		{
+			for(size_t w = 0; w < num_words; ++w)
+			{
+				size_t const count = popcount(valid[w]);
+				if(sel < count)
+				{
+					return w * 64 + select_bit(valid[w], sel);
+				}
+				sel -= count;
+			}
+
+			assert(false);
+			return 0;
+		}
+
+	protected:
+		bool								m_use_naive;
+		std::vector< range_data >			m_range_data;
+		std::vector< size_t >				m_draw_order;	// Players in the order their hands are drawn
+		size_t								m_max_words;	// Most words in any player's bitsets
+	};
+
+	/*!
+	A path generation policy for selecting a random hand tuple when ranges overlap heavily, where RangeTuple_PathGen's independent
+	draws would mostly be rejected. Draws hands as described for BlockerAware_SharedData, read from the spec, or falls back to
+	RangeTuple_PathGen if its pilot found that to be cheaper.
+	*/
+	class BlockerAware_PathGen: public RangeTuple_PathGen
+	{
+	public:
+		BlockerAware_PathGen(): m_data(nullptr)
+		{}
+
+		template < typename SimSpec >
+		void initialize(SimSpec const& spec)
+		{
+			RangeTuple_PathGen::initialize(spec);
+
+			m_data = &spec.get_blocker_aware_data();
+			m_data->initialize_scratch(m_scratch);
+		}
+
+		template < typename SimSpec, typename SimContext, typename PathState >
+		void generate_path(SimSpec const& spec, SimContext& context, PathState& path_state) const
+		{
+			if(m_data->use_naive())
+			{
+				RangeTuple_PathGen::generate_path(spec, context, path_state);
+				return;
+			}
+
+			uint64_t work = 0;
+			while(true)	// Assuming that there are possible simulations
+			{
+				Cardset blocked = spec.get_initially_blocked();
+				auto const on_hand = [&spec, &path_state, &blocked](size_t const player, size_t const hand_index)
+				{
+					// This hand is ok, store required components in the simulation state hand accessor
+					path_state.on_initialize_player_hand(player, hand_index, spec);
+					blocked |= spec.get_hand_data< Hand_Mask >(player, hand_index);
+				};
+
+				if(m_data->attempt(spec, context.gen, m_scratch, on_hand, work))
+				{
+					path_state.deck -= blocked;
+					return;
+				}
+			}
+		}
+
+	protected:
+		BlockerAware_SharedData const*				m_data;
+		mutable BlockerAware_SharedData::scratch_t	m_scratch;		// Working storage for generate_path
+	};
+
+}
+}
+
+
+#endif
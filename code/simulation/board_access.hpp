@@ -10,6 +10,8 @@ Defines the policy classes for providing access to the currently sampled board w
 #include <boost/mpl/inherit.hpp>
 #include <boost/mpl/for_each.hpp>
 
+#include <cassert>
+
 
 namespace epw {
 namespace sim {
@@ -36,6 +38,20 @@ namespace sim {
 
 		components_t	m_components;
 
+		struct reset_component_ftr
+		{
+			this_t& board;
+
+			inline reset_component_ftr(this_t& b): board(b)
+			{}
+
+			template < typename BoardCompTag >
+			inline void operator() (boost::mpl::identity< BoardCompTag >)
+			{
+				board.get_board_data< BoardCompTag >() = typename BoardCompTag::data_t();
+			}
+		};
+
 		struct board_card_ftr
 		{
 			Card const& card;
@@ -51,6 +67,21 @@ namespace sim {
 			}
 		};
 
+		struct remove_board_card_ftr
+		{
+			Card const& card;
+			this_t& board;
+
+			inline remove_board_card_ftr(Card const& c, this_t& b): card(c), board(b)
+			{}
+
+			template < typename BoardCompTag >
+			inline void operator() (boost::mpl::identity< BoardCompTag >)
+			{
+				BoardCompTag::on_remove_board_card(card, board);
+			}
+		};
+
 	public:
 		// TODO: if gonna include this in board policy, then implement in a BoardPolicy_Base class, and each policy implementation must derive from this
 		size_t			board_count;
@@ -59,7 +90,7 @@ namespace sim {
 		inline BoardAccess_Default(): m_components(), board_count(0)
 		{
 			// TODO: remove and work out why not being value initialized through m_components()
-			get_board_data< Board_Mask >() = Board_Mask::data_t();
+			boost::mpl::for_each< board_component_tag_list_t, boost::mpl::make_identity< boost::mpl::_1 > >(reset_component_ftr(*this));
 		}
 
 	public:
@@ -78,6 +109,19 @@ namespace sim {
 			++board_count;
 		}
 
+		/*!
+		Undoes on_board_card() for the most recently added card, so that a board can be explored depth first on a single path state.
+		Cards must be removed in the reverse of the order they were added.
+		*/
+		inline void on_remove_board_card(Card const& card)
+		{
+			assert(board_count > 0);
+
+			--board_count;
+
+			boost::mpl::for_each< board_component_tag_list_t, boost::mpl::make_identity< boost::mpl::_1 > >(remove_board_card_ftr(card, *this));
+		}
+
 		template < typename BoardCompTag >
 		inline const typename BoardCompTag::data_t& get_board_data() const
 		{
@@ -5,6 +5,7 @@
 
 #include "poker_core/cardset.hpp"
 #include "poker_core/board.hpp"
+#include "hand_eval/omaha_hand_eval.hpp"
 
 #include <array>
 
@@ -26,6 +27,12 @@ namespace sim {
 		{
 			path_state.get_board_data< Board_Mask >() |= Cardset::from_card(card);
 		}
+
+		template < typename PathState >
+		static inline void on_remove_board_card(Card const& card, PathState& path_state)
+		{
+			path_state.get_board_data< Board_Mask >().remove(card);
+		}
 	};
 
 	/*! A card list representation of the board
@@ -39,6 +46,12 @@ namespace sim {
 		{
 			path_state.get_board_data< Board_Cards >().add(card);
 		}
+
+		template < typename PathState >
+		static inline void on_remove_board_card(Card const& card, PathState& path_state)
+		{
+			path_state.get_board_data< Board_Cards >().remove_last();
+		}
 	};
 
 	/*! A set of 10 (TODO: sometimes there are less than 10 unique ones) three card combos from a board, consisting of 3 ranks and a suit specifier
@@ -51,18 +64,41 @@ namespace sim {
 			Card::suit_t					suit;
 		};
 
-		typedef std::array< three_rank_combo, 10 >	data_t;
+		/*! The combos, along with the board cards they were built from, which are needed to undo the addition of a card */
+		struct data_t: public std::array< three_rank_combo, 10 >
+		{
+			Board		cards;
+		};
 
 
 		template < typename PathState >
 		static inline void on_board_card(Card const& card, PathState& path_state)
+		{
+			data_t& data = path_state.get_board_data< Board_ThreeRankCombos >();
+			apply_card(card, data.cards.count, data);
+			data.cards.add(card);
+		}
+
+		/*! Combos which were merged with the removed card cannot be unmerged, so are rebuilt from the remaining cards */
+		template < typename PathState >
+		static inline void on_remove_board_card(Card const& card, PathState& path_state)
+		{
+			data_t& data = path_state.get_board_data< Board_ThreeRankCombos >();
+			data.cards.remove_last();
+			for(size_t i = 0; i < data.cards.count; ++i)
+			{
+				apply_card(data.cards[i], i, data);
+			}
+		}
+
+	private:
+		static inline void apply_card(Card const& card, size_t const position, data_t& tr_combos)
 		{
 			const Card::rank_t rank = card.get_rank();
 			const Card::suit_t suit = card.get_suit();
-			data_t& tr_combos = path_state.get_board_data< Board_ThreeRankCombos >();
 
 			// TODO: better way? since for each tree node the number of new board cards it must generate is fixed, shouldn't need to switch really
-			switch(path_state.board_count)
+			switch(position)
 			{
 			case 0:
 				tr_combos[0].ranks[0] = rank;
@@ -139,6 +175,85 @@ namespace sim {
 		}
 	};
 
+	/*! The precalculated board key used by the direct lookup omaha evaluator. Keeps its own copy of the board cards so as not to
+	depend on the presence of Board_Cards.
+	*/
+	struct Board_OmahaEvalKey
+	{
+		struct data_t
+		{
+			Board						cards;
+			OmahaHandEval::BoardKey		key;
+		};
+
+		template < typename PathState >
+		static inline void on_board_card(Card const& card, PathState& path_state)
+		{
+			data_t& data = path_state.get_board_data< Board_OmahaEvalKey >();
+			data.cards.add(card);
+			if(data.cards.count >= OmahaHandEval::MIN_BOARD_CARDS)
+			{
+				data.key = OmahaHandEval::prepare_board(data.cards);
+			}
+		}
+
+		template < typename PathState >
+		static inline void on_remove_board_card(Card const& card, PathState& path_state)
+		{
+			data_t& data = path_state.get_board_data< Board_OmahaEvalKey >();
+			data.cards.remove_last();
+			if(data.cards.count >= OmahaHandEval::MIN_BOARD_CARDS)
+			{
+				data.key = OmahaHandEval::prepare_board(data.cards);
+			}
+		}
+	};
+
+	/*! Tables, built once the board is complete, of the best value obtainable with each of the 91 two-rank combos: one for any two
+	hand cards, and one for two hand cards both of the board's flush suit (if it has one). Per player evaluation then needs no further
+	board related work.
+	*/
+	struct Board_RankPairTable
+	{
+		enum {
+			NUM_TWO_RANK_COMBOS = OmahaHandEval::NUM_TWO_RANK_COMBOS,
+
+			// Distinct from any suit, including the UNKNOWN_SUIT used for unsuited hand combos
+			NO_FLUSH_SUIT = Card::UNKNOWN_SUIT + 1,
+		};
+
+		struct data_t
+		{
+			Board											cards;
+			unsigned char									flush_suit;
+			std::array< HandVal, NUM_TWO_RANK_COMBOS >		nonflush;
+			std::array< HandVal, NUM_TWO_RANK_COMBOS >		suited;
+
+			data_t(): flush_suit(NO_FLUSH_SUIT)
+			{}
+		};
+
+		template < typename PathState >
+		static inline void on_board_card(Card const& card, PathState& path_state)
+		{
+			data_t& data = path_state.get_board_data< Board_RankPairTable >();
+			data.cards.add(card);
+			if(data.cards.count == MAX_BOARD_CARDS)
+			{
+				OmahaHandEval::BoardKey const key = OmahaHandEval::prepare_board(data.cards);
+				OmahaHandEval::build_rank_pair_table(key, data.nonflush.data(), data.suited.data());
+				data.flush_suit = key.flush_suit != Card::UNKNOWN_SUIT ? (unsigned char)key.flush_suit : (unsigned char)NO_FLUSH_SUIT;
+			}
+		}
+
+		/*! The tables are only read on a complete board, and are rebuilt when it is next completed */
+		template < typename PathState >
+		static inline void on_remove_board_card(Card const& card, PathState& path_state)
+		{
+			path_state.get_board_data< Board_RankPairTable >().cards.remove_last();
+		}
+	};
+
 }
 }
 
@@ -0,0 +1,311 @@
+// enumeration_core.hpp
+
+#ifndef EPW_ENUMERATION_CORE_H
+#define EPW_ENUMERATION_CORE_H
+
+#include "simulation_core.hpp"
+#include "hand_access_components.hpp"
+
+#include "poker_core/cardset.hpp"
+#include "poker_core/suit_isomorphism.hpp"
+#include "hand_eval/showdown_outcome.hpp"
+#include "gen_util/combinatorics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+
+namespace epw {
+namespace sim {
+
+	/*!
+	A drop-in alternative to SimulationCore which, rather than having the path traverser deal a random board runout, visits every
+	possible runout of the remaining deck exactly once for each hand tuple, passing each completed path to the traverser's
+	evaluate_path().
+
+	If EnumerateHands is false, hand tuples are still selected by the path generator, and each call to run() generates the given
+	number of tuples. If it is true, the path generator is not used and every compatible hand tuple is visited exactly once, giving
+	an exact result. In this case the tuples are partitioned between the cores sharing the simulation by the index of the first
+	player's hand, and the sample count passed to run() is ignored.
+
+	Since a single call to run() can take a long time, it can be given a flag to stop early on, which is checked between hand tuples.
+
+	Since the number of runouts does not depend on the hand tuple, every tuple carries equal weight in the results.
+
+	When enumerating hands, if some suit permutation leaves the board, every player's hand and the remaining deck unchanged, runouts
+	which are suit permutations of one another give the same results, so only one runout of each such class is visited, passed to
+	evaluate_path() along with the number of runouts it stands for.
+	*/
+	template <
+		typename SimSpec,
+		typename SimContext,
+		typename PathState,
+		typename PathGen,
+		typename PathTraversal,
+		bool EnumerateHands = false
+	>
+	class EnumerationCore
+	{
+	public:
+		typedef SimSpec									sim_spec_t;
+
+	private:
+		typedef SimContext								sim_context_t;
+		typedef PathState								path_state_t;
+		typedef PathGen									path_gen_t;
+		typedef PathTraversal							path_traversal_t;
+
+	public:
+		typedef typename path_traversal_t::results_t	results_t;
+
+		enum {
+			// Hand enumeration covers this core's whole share in one call, and a random tuple can stand for very many runouts
+			INCREMENTAL = false,
+
+			// When enumerating hands, the cores running the simulation each take a share of the hand tuples
+			PARTITIONED = EnumerateHands,
+		};
+
+	public:
+		EnumerationCore(sim_spec_t const& _sim_spec): m_sim_spec(_sim_spec), m_core_index(0), m_num_cores(1), m_cancelled(nullptr)
+		{}
+
+		/*! Number of board runouts visited for every hand tuple */
+		static sample_count_t runouts_per_tuple(sim_spec_t const& spec)
+		{
+			size_t num_live = FULL_DECK_SIZE - spec.get_initially_blocked().size();
+			size_t const num_players = spec.get_num_players();
+			for(size_t i = 0; i < num_players; ++i)
+			{
+				num_live -= spec.get_hand_data< Hand_Mask >(i, 0).size();
+			}
+
+			return combinations::calc(num_live, path_traversal_t::board_cards_needed(spec));
+		}
+
+		/*!
+		Upper bound on the number of paths visited by a full enumeration, from the product of the range sizes (which counts tuples
+		with conflicting hands too) and the runouts per tuple. Returned as a double, since it can exceed the range of sample_count_t.
+		*/
+		static double enumerated_paths_bound(sim_spec_t const& spec)
+		{
+			double tuples = 1.0;
+			size_t const num_players = spec.get_num_players();
+			for(size_t i = 0; i < num_players; ++i)
+			{
+				tuples *= spec.get_player_range_size(i);
+			}
+
+			return tuples * runouts_per_tuple(spec);
+		}
+
+		/*! Number of hand tuples to generate in order for approximately num_samples paths to be evaluated */
+		static sample_count_t tuples_for_samples(sim_spec_t const& spec, sample_count_t const num_samples)
+		{
+			sample_count_t const per_tuple = runouts_per_tuple(spec);
+			return std::max< sample_count_t >((num_samples + per_tuple - 1) / per_tuple, 1);
+		}
+
+		/*! One-time core initialization. core_index identifies this core amongst the num_cores running the same simulation. */
+		void initialize(size_t core_index = 0, size_t num_cores = 1)
+		{
+			m_core_index = core_index;
+			m_num_cores = num_cores;
+
+			m_context.initialize(m_sim_spec, core_index);
+			if(!EnumerateHands)
+			{
+				m_path_generator.initialize(m_sim_spec);
+			}
+			m_path_traverser.initialize(m_sim_spec);
+		}
+
+		/*! Runs num_tuples hand tuples, or this core's share of all tuples if EnumerateHands. Assumes initialize() has been called already */
+		void run(sample_count_t const num_tuples)
+		{
+			std::atomic< bool > const never_cancelled(false);
+			run(num_tuples, never_cancelled);
+		}
+
+		/*! As run(), but returning early, with partial results, once cancelled is set */
+		void run(sample_count_t const num_tuples, std::atomic< bool > const& cancelled)
+		{
+			m_cancelled = &cancelled;
+
+			path_state_t initial_path_state;
+			initial_path_state.initialize(m_sim_spec);
+
+			if(EnumerateHands)
+			{
+				path_state_t path_state(initial_path_state);
+				enumerate_hands(path_state, 0, m_sim_spec.get_initially_blocked());
+			}
+			else
+			{
+				for(sample_count_t t = 0; t < num_tuples && !is_cancelled(); ++t)
+				{
+					path_state_t path_state(initial_path_state);
+					m_path_generator.generate_path(
+						m_sim_spec,
+						m_context,
+						path_state
+						);
+
+					enumerate_runouts(path_state);
+				}
+			}
+
+			m_cancelled = nullptr;
+		}
+
+		void get_results(results_t& res) const
+		{
+			m_path_traverser.get_results(res);
+		}
+
+	private:
+		inline bool is_cancelled() const
+		{
+			return m_cancelled->load(std::memory_order_relaxed);
+		}
+
+		/*! Recursively assigns every compatible hand to each player from player onwards, then enumerates the runouts for each tuple */
+		void enumerate_hands(path_state_t& path_state, size_t const player, Cardset const blocked)
+		{
+			size_t const num_players = m_sim_spec.get_num_players();
+			if(player == num_players)
+			{
+				Cardset const deck = path_state.deck;
+				path_state.deck -= blocked;
+
+				// Board, hands and remaining deck must all be preserved by a permutation for it to be a symmetry of the runouts
+				std::array< Cardset, suit_iso::MAX_SETS > fixed;
+				fixed[0] = Cardset(m_sim_spec.m_initial_board.begin(), m_sim_spec.m_initial_board.end());
+				std::copy(m_hand_masks.begin(), m_hand_masks.begin() + num_players, fixed.begin() + 1);
+				fixed[num_players + 1] = path_state.deck;
+				if(suit_iso::stabilizer(fixed.data(), num_players + 2) > 1)
+				{
+					enumerate_canonical_runouts(path_state, fixed.data(), num_players + 2);
+				}
+				else
+				{
+					enumerate_runouts(path_state);
+				}
+
+				path_state.deck = deck;
+				return;
+			}
+
+			size_t const first = player == 0 ? m_core_index : 0;
+			size_t const step = player == 0 ? m_num_cores : 1;
+			size_t const range_size = m_sim_spec.get_player_range_size(player);
+			for(size_t h = first; h < range_size && !is_cancelled(); h += step)
+			{
+				Cardset const hand_mask = m_sim_spec.get_hand_data< Hand_Mask >(player, h);
+				if(hand_mask.contains_any(blocked))
+				{
+					continue;
+				}
+
+				path_state.on_initialize_player_hand(player, h, m_sim_spec);
+				m_hand_masks[player] = hand_mask;
+				enumerate_hands(path_state, player + 1, blocked | hand_mask);
+			}
+		}
+
+		/*! Visits every runout of the required number of board cards from the path's deck */
+		inline void enumerate_runouts(path_state_t& path_state)
+		{
+			std::array< Card, FULL_DECK_SIZE > live;
+			size_t const num_live = path_state.deck.get_cards(live.data());
+
+			enumerate_runouts(path_state, live.data(), num_live, 0, path_traversal_t::board_cards_needed(m_sim_spec));
+		}
+
+		void enumerate_runouts(path_state_t& path_state, Card const live[], size_t const num_live, size_t const start, size_t const remaining)
+		{
+			if(remaining == 0)
+			{
+				m_path_traverser.evaluate_path(
+					m_sim_spec,
+					m_context,
+					path_state
+					);
+				return;
+			}
+
+			// Cards are taken in increasing order of position in the live array, so each runout is visited once only.
+			// Each card is added to and then removed from the one path state, rather than copying the state for every card.
+			for(size_t i = start; i + remaining <= num_live; ++i)
+			{
+				path_state.on_board_card(live[i]);
+				path_state.deck.remove(live[i]);
+
+				enumerate_runouts(path_state, live, num_live, i + 1, remaining - 1);
+
+				path_state.deck.insert(live[i]);
+				path_state.on_remove_board_card(live[i]);
+			}
+		}
+
+		/*! Visits one runout from each class of runouts equivalent under the suit permutations preserving the fixed cardsets */
+		inline void enumerate_canonical_runouts(path_state_t& path_state, Cardset const fixed[], size_t const num_fixed)
+		{
+			suit_iso::enumerate_canonical_subsets(
+				path_state.deck,
+				path_traversal_t::board_cards_needed(m_sim_spec),
+				fixed,
+				num_fixed,
+				[this, &path_state](Cardset const runout, size_t const weight)
+				{
+					std::array< Card, MAX_BOARD_CARDS > cards;
+					size_t const num_cards = runout.get_cards(cards.data());
+					for(size_t i = 0; i < num_cards; ++i)
+					{
+						path_state.on_board_card(cards[i]);
+					}
+					path_state.deck -= runout;
+
+					m_path_traverser.evaluate_path(
+						m_sim_spec,
+						m_context,
+						path_state,
+						weight
+						);
+
+					path_state.deck |= runout;
+					for(size_t i = num_cards; i > 0; --i)
+					{
+						path_state.on_remove_board_card(cards[i - 1]);
+					}
+				});
+		}
+
+	private:
+		/*! Reference to the unchanging simulation specification */
+		sim_spec_t const& m_sim_spec;
+
+		/*! This core's share of the hand tuples when enumerating hands */
+		size_t m_core_index;
+		size_t m_num_cores;
+
+		/*! Set while run() is in progress */
+		std::atomic< bool > const* m_cancelled;
+
+		/*! Hands of the tuple currently being enumerated */
+		std::array< Cardset, MaxPlayersDealtIn > m_hand_masks;
+
+		sim_context_t m_context;
+
+		path_gen_t m_path_generator;
+
+		path_traversal_t m_path_traverser;
+	};
+
+}
+}
+
+
+#endif
+
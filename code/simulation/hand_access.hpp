@@ -8,10 +8,15 @@ configured to hold no more than what will be needed by the path traversal implem
 #ifndef EPW_HAND_ACCESS_H
 #define EPW_HAND_ACCESS_H
 
+#include "hand_eval/showdown_outcome.hpp"
+
 #include <boost/mpl/inherit_linearly.hpp>
 #include <boost/mpl/inherit.hpp>
 #include <boost/mpl/for_each.hpp>
 
+#include <array>
+#include <cstdint>
+
 
 namespace epw {
 namespace sim {
@@ -36,7 +41,8 @@ namespace sim {
 
 		typedef typename boost::mpl::inherit_linearly< hand_component_tag_list_t, boost::mpl::inherit< boost::mpl::_1, CompData< boost::mpl::_2 > > >::type components_t;
 
-		std::array< components_t, 10 /* TODO: MAX_PLAYERS_PER_HAND */ >	m_components;
+		std::array< components_t, MaxPlayersDealtIn >	m_components;
+		std::array< uint32_t, MaxPlayersDealtIn >		m_hand_indices;
 
 		template < typename RangeStorage >
 		struct init_player_hand_ftr
@@ -73,6 +79,13 @@ namespace sim {
 		__forceinline void on_initialize_player_hand(size_t player, size_t index, RangeStorage const& ranges)	// index is into initial hand range of player
 		{
 			boost::mpl::for_each< hand_component_tag_list_t, boost::mpl::make_identity< boost::mpl::_1 > >(init_player_hand_ftr< RangeStorage >(player, index, *this, ranges));
+			m_hand_indices[player] = (uint32_t)index;
+		}
+
+		/*! Index of the player's current hand within their range */
+		inline size_t get_current_hand_index(size_t player) const
+		{
+			return m_hand_indices[player];
 		}
 
 		template < typename HandCompTag >
@@ -88,50 +101,50 @@ namespace sim {
 		}
 	};
 
-/*
-	template < typename HandStoragePolicy >
-	class HandAccess_Ref: public NullPolicyImpl< HandAccess_Ref< HandStoragePolicy > >
+	/*!
+	Alternative to HandAccess_Copy which copies nothing. Only the index of each player's hand within their range is stored, along with
+	a pointer to the RangeStorage (normally the sim spec), and components are read from the storage's immutable hand data on every
+	access. This makes initializing a hand, and copying a path state, cost a few bytes per player regardless of which components are
+	required, at the price of an extra indirection per access. The storage must outlive any path states referring to it.
+
+	HandCompTagList documents the components required, as for HandAccess_Copy, but any component the storage provides can be read.
+	*/
+	template <
+		typename HandCompTagList,		// mpl container of types specifying which hand data elements are required
+		typename RangeStorage
+	>
+	class HandAccess_Ref
 	{
 	protected:
-		typedef HandStoragePolicy hand_storage_t;
-
-		struct hand_state
-		{
-			int		hand_index;
-		};
+		typedef HandCompTagList										hand_component_tag_list_t;
+		typedef RangeStorage										range_storage_t;
 
-		const hand_storage_t& m_storage_policy;
+		range_storage_t const*							m_ranges;
+		std::array< uint32_t, MaxPlayersDealtIn >		m_hand_indices;
 
 	public:
-		HandAccess_Ref(const hand_storage_t& hsp): m_storage_policy(hsp)
+		inline HandAccess_Ref(): m_ranges(nullptr)
 		{}
 
-	protected:
-		template < typename State >
-		void initialize_player_hand(State& state, size_t player, size_t index)	// index into initial hand range of player
-		{
-			state.hand_index = index;
-		}
-
-		template < typename State >
-		inline const uint64_t& get_hand_mask(const State& state, size_t player) const
+	public:
+		__forceinline void on_initialize_player_hand(size_t player, size_t index, range_storage_t const& ranges)	// index is into initial hand range of player
 		{
-			return m_storage_policy.get_hand_mask(player, state.hand_index);
+			m_ranges = &ranges;
+			m_hand_indices[player] = (uint32_t)index;
 		}
 
-		template < typename State >
-		inline const pkr::OmahaCards& get_hand_cards(const State& state, size_t player) const
+		/*! Index of the player's current hand within their range */
+		inline size_t get_current_hand_index(size_t player) const
 		{
-			return m_storage_policy.get_hand_cards(player, state.hand_index);
+			return m_hand_indices[player];
 		}
 
-		template < typename State >
-		inline const DistinctOmahaHand::TwoCardIndex& get_hand_twocardcombo(const State& state, size_t player, size_t tcc_index) const
+		template < typename HandCompTag >
+		inline const typename HandCompTag::data_t& get_current_hand_data(size_t player) const
 		{
-			return m_storage_policy.get_hand_twocardcombo(player, state.hand_index, tcc_index);
+			return m_ranges->get_hand_data< HandCompTag >(player, m_hand_indices[player]);
 		}
 	};
-*/
 }
 }
 
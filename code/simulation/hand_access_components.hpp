@@ -31,11 +31,11 @@ namespace sim {
 		typedef Cardset	data_t;
 	};
 
-	/*! A card list representation of a player's hand
+	/*! A card list representation of a player's hand, as compact card indices with operator[] access to Cards
 	*/
 	struct Hand_Cards
 	{
-		typedef omaha::Hand data_t;
+		typedef LookupTables::OmahaHand::omaha_cards_t data_t;
 	};
 
 	/*! A set of 6 (TODO: sometimes there are less than 6 unique ones) two card combos from an omaha hand, consisting of 2 ranks and a suit specifier
@@ -5,7 +5,7 @@
 
 #include "multiple_range_and_board_sim_spec.hpp"
 #include "sim_board_gen.hpp"			// TODO: remove when templatize this
-#include "sim_handeval_bitmask.hpp"		// same
+#include "sim_handeval_direct.hpp"		// same
 #include "sim_results.hpp"
 
 #include "gen_util/combinatorics.hpp"	// TODO: as above
@@ -33,12 +33,50 @@ namespace sim {
 	class HandTypeCountSim_PathTraversal
 	{
 	public:
+		typedef HandEval_OmahaDirect								hand_eval_t;
+
+		typedef hand_eval_t::req_hand_subcomponents_t				req_hand_subcomponents_t;
+		typedef hand_eval_t::req_board_subcomponents_t				req_board_subcomponents_t;
+
 		typedef std::array< size_t, HandVal::HandType::COUNT >		handtype_counts_t;
 
 		struct results_t:
 			public SimResultsBase,
 			public std::vector< handtype_counts_t >
-		{};
+		{
+			inline void combine_with(results_t const& other)
+			{
+				SimResultsBase::combine_with(other);
+
+				assert(size() == other.size());
+				for(size_t p = 0; p < size(); ++p)
+				{
+					for(size_t ht = 0; ht < HandVal::HandType::COUNT; ++ht)
+					{
+						(*this)[p][ht] += other[p][ht];
+					}
+				}
+			}
+
+			/*! Frequency of a hand type for a player */
+			inline Estimate get_estimate(size_t const p, size_t const ht) const
+			{
+				return estimate_from_count((*this)[p][ht], num_samples);
+			}
+
+			inline double get_max_std_err() const
+			{
+				double max_err = 0.0;
+				for(size_t p = 0; p < size(); ++p)
+				{
+					for(size_t ht = 0; ht < HandVal::HandType::COUNT; ++ht)
+					{
+						max_err = std::max(max_err, get_estimate(p, ht).std_err);
+					}
+				}
+				return max_err;
+			}
+		};
 
 	public:
 		template < typename SimSpec >
@@ -48,23 +86,38 @@ namespace sim {
 			m_counts.resize(num_players);
 		}
 
+		/*! Number of cards that must be dealt to reach the street of interest on each path */
+		template < typename SimSpec >
+		static inline size_t board_cards_needed(SimSpec const& spec)
+		{
+			// TODO: this should be calculated once in sim initialization
+			return flopgame::BOARD_CARDS_BY_STREET[spec.m_street] - spec.m_initial_board.count;
+		}
+
 		template < typename SimSpec, typename SimContext, typename PathState >
 		inline void	traverse_path(SimSpec const& spec, SimContext& context, PathState& path_state)
 		{
-			// TODO: this should be calculated once in sim initialization
-			size_t const board_cards_needed = flopgame::BOARD_CARDS_BY_STREET[spec.m_street] - spec.m_initial_board.count;
+			LiveDeckBoardGen::runout_board(board_cards_needed(spec), context, path_state);
 
-			BasicBoardGen::runout_board(board_cards_needed, context, path_state);
+			evaluate_path(spec, context, path_state);
+		}
 
+		/*!
+		Counts the hand types made on a path whose board has already been dealt up to the street of interest. weight is the number of
+		equivalent paths that this one stands for.
+		*/
+		template < typename SimSpec, typename SimContext, typename PathState >
+		inline void	evaluate_path(SimSpec const& spec, SimContext& context, PathState& path_state, uint64_t const weight = 1)
+		{
 			size_t const num_players = spec.get_num_players();
 			for(size_t i = 0; i < num_players; ++i)
 			{
-				HandVal val = HandEval_Bitmask::evaluate_player_hand(i, path_state);
+				HandVal val = hand_eval_t::evaluate_player_hand(i, path_state);
 				HandVal::HandType type = val.type();
-				++m_counts[i][type];
+				m_counts[i][type] += weight;
 			}
 
-			++m_counts.num_samples;
+			m_counts.num_samples += weight;
 		}
 
 		inline void get_results(results_t& res) const
@@ -3,6 +3,8 @@
 #include "lookup_tables.hpp"
 
 #include "hand_eval/poker_hand_eval.hpp"
+#include "hand_eval/poker_hand_eval_batch.hpp"
+#include "preflop_matchup_store.hpp"
 
 #include "poker_core/card_match_defs.hpp"
 #include "poker_core/card_match_char_mapping_epw.hpp"
@@ -10,22 +12,63 @@
 
 #include "parsing/parser_helpers.hpp"
 
+#include "gen_util/sysutil.hpp"
+
 #include <boost/function.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
+#include <cstring>
 #include <fstream>
+#include <memory>
+#include <vector>
 
 
 namespace epw {
 namespace sim {
 
-	LookupTables::OmahaHand LookupTables::s_all_omaha_hands[combinations::ct< FULL_DECK_SIZE, 4 >::res];
-	HandVal LookupTables::s_omaha_hand_vals[NUM_TWO_RANK_COMBOS][NUM_THREE_RANK_COMBOS];
-	size_t LookupTables::s_three_rank_combos[Card::RANK_COUNT][Card::RANK_COUNT][Card::RANK_COUNT];
-	LookupTables::omaha_ranking_t LookupTables::s_default_omaha_ranking;
+	struct LookupTables::GeneratedTables
+	{
+		alignas(CACHE_LINE_SIZE) Cardset omaha_hand_masks[NUM_OMAHA_HANDS];
+		alignas(CACHE_LINE_SIZE) OmahaHand::omaha_cards_t omaha_hand_cards[NUM_OMAHA_HANDS];
+		alignas(CACHE_LINE_SIZE) OmahaHand::PaddedTwoRankCombos omaha_hand_tr_combos[NUM_OMAHA_HANDS];
+		HandVal omaha_hand_vals[NUM_TWO_RANK_COMBOS][NUM_THREE_RANK_COMBOS];
+		size_t three_rank_combos[Card::RANK_COUNT][Card::RANK_COUNT][Card::RANK_COUNT];
+		omaha_ranking_t default_omaha_ranking;
+	};
+
+	LookupTables::GeneratedTables& LookupTables::generated()
+	{
+		static std::unique_ptr< GeneratedTables > tables(new GeneratedTables());
+		return *tables;
+	}
+
+	namespace {
+
+		boost::interprocess::file_mapping s_blob_file;
+		boost::interprocess::mapped_region s_blob_region;
+
+	}
+
+	Cardset const* LookupTables::s_omaha_hand_masks = nullptr;
+	LookupTables::OmahaHand::omaha_cards_t const* LookupTables::s_omaha_hand_cards = nullptr;
+	LookupTables::OmahaHand::PaddedTwoRankCombos const* LookupTables::s_omaha_hand_tr_combos = nullptr;
+	HandVal const (*LookupTables::s_omaha_hand_vals)[NUM_THREE_RANK_COMBOS] = nullptr;
+	size_t const (*LookupTables::s_three_rank_combos)[Card::RANK_COUNT][Card::RANK_COUNT] = nullptr;
+	size_t const* LookupTables::s_default_omaha_ranking = nullptr;
 	LookupTables::flags_t LookupTables::s_initialized;
 
 	bool LookupTables::initialize(flags_t const& flags)
 	{
+		if(flags.test(MAPPED_TABLES) && !s_initialized.test(MAPPED_TABLES))
+		{
+			if(!map_default_blob())
+			{
+				return false;
+			}
+			s_initialized.set(MAPPED_TABLES);
+		}
+
 		if(flags.test(OMAHA_HANDS) && !s_initialized.test(OMAHA_HANDS))
 		{
 			if(!generate_all_omaha_hands())
@@ -62,12 +105,50 @@ namespace sim {
 			s_initialized.set(OMAHA_RANKING);
 		}
 
+		if(flags.test(OMAHA_EVAL) && !s_initialized.test(OMAHA_EVAL))
+		{
+			if(!OmahaHandEval::initialize())
+			{
+				return false;
+			}
+			s_initialized.set(OMAHA_EVAL);
+		}
+
+		if(flags.test(HOLDEM_EVAL) && !s_initialized.test(HOLDEM_EVAL))
+		{
+			if(!HoldemHandEval::initialize())
+			{
+				return false;
+			}
+			s_initialized.set(HOLDEM_EVAL);
+		}
+
+		if(flags.test(BATCH_EVAL) && !s_initialized.test(BATCH_EVAL))
+		{
+			if(!PokerHandEvalBatch::initialize())
+			{
+				return false;
+			}
+			s_initialized.set(BATCH_EVAL);
+		}
+
+		if(flags.test(PREFLOP_MATCHUPS) && !s_initialized.test(PREFLOP_MATCHUPS))
+		{
+			if(!open_default_matchup_store())
+			{
+				return false;
+			}
+			s_initialized.set(PREFLOP_MATCHUPS);
+		}
+
 		return true;
 	}
 
 	bool LookupTables::generate_all_omaha_hands()
 	{
-		size_t lex_idx = combinations::ct< FULL_DECK_SIZE, 4 >::res;
+		GeneratedTables& gen = generated();
+
+		size_t lex_idx = NUM_OMAHA_HANDS;
 		omaha::Hand cards;
 		Cardset mask;
 		for(int a = FULL_DECK_SIZE - 1; a >= 3; --a)
@@ -88,15 +169,18 @@ namespace sim {
 						mask.insert(cards[3]);
 						--lex_idx;
 						
-						s_all_omaha_hands[lex_idx].cards = cards;
-						s_all_omaha_hands[lex_idx].mask = mask;
+						gen.omaha_hand_masks[lex_idx] = mask;
+						for(size_t i = 0; i < omaha::CARDS_PER_HAND; ++i)
+						{
+							gen.omaha_hand_cards[lex_idx].indices[i] = (uint8_t)cards[i].get_index();
+						}
 
 						size_t trc_idx = 0;
 						for(size_t trc_a = 0; trc_a < 4; ++trc_a)
 						{
 							for(size_t trc_b = trc_a + 1; trc_b < 4; ++trc_b)
 							{
-								s_all_omaha_hands[lex_idx].tr_combos[trc_idx] = OmahaHand::SuitedTwoRankCombo(
+								gen.omaha_hand_tr_combos[lex_idx].combos[trc_idx] = OmahaHand::SuitedTwoRankCombo(
 									cards[trc_a].get_rank(),
 									cards[trc_b].get_rank(),
 									cards[trc_a].get_suit() == cards[trc_b].get_suit() ? cards[trc_a].get_suit() : Card::UNKNOWN_SUIT
@@ -113,11 +197,17 @@ namespace sim {
 			}
 			mask.remove(cards[0]);
 		}
+
+		s_omaha_hand_masks = gen.omaha_hand_masks;
+		s_omaha_hand_cards = gen.omaha_hand_cards;
+		s_omaha_hand_tr_combos = gen.omaha_hand_tr_combos;
 		return true;
 	}
 
 	bool LookupTables::generate_omaha_hand_vals()
 	{
+		GeneratedTables& gen = generated();
+
 		std::array< size_t, Card::RANK_COUNT > rank_counts;
 		rank_counts.assign(Card::SUIT_COUNT);
 		Cardset cards;
@@ -148,7 +238,7 @@ namespace sim {
 
 							cards.insert(Card((Card::rank_t)br3, (Card::suit_t)--rank_counts[br3]));
 
-							s_omaha_hand_vals[hand_lex_idx][board_lex_idx] = PokerHandEval::EvaluateHandFtr< PokerHandEval::NoFlushPossible >()(cards, 5);
+							gen.omaha_hand_vals[hand_lex_idx][board_lex_idx] = PokerHandEval::EvaluateHandFtr< PokerHandEval::NoFlushPossible >()(cards, 5);
 
 							cards.remove(Card((Card::rank_t)br3, (Card::suit_t)rank_counts[br3]++));
 						}
@@ -160,11 +250,15 @@ namespace sim {
 			}
 			cards.remove(Card((Card::rank_t)hr1, (Card::suit_t)rank_counts[hr1]++));
 		}
+
+		s_omaha_hand_vals = gen.omaha_hand_vals;
 		return true;
 	}
 
 	bool LookupTables::generate_three_rank_combos()
 	{
+		GeneratedTables& gen = generated();
+
 		epw::combinatorics< epw::basic_rt_combinations_r > comb;
 
 		for(int i = 0; i < Card::RANK_COUNT; ++i)
@@ -174,20 +268,24 @@ namespace sim {
 				for(int k = j; k < Card::RANK_COUNT; ++k)
 				{
 					size_t lex_idx = comb.element_to_lex(epw::elem< 3 >(k, j, i));
-					s_three_rank_combos[i][j][k] = lex_idx;
-					s_three_rank_combos[i][k][j] = lex_idx;
-					s_three_rank_combos[j][i][k] = lex_idx;
-					s_three_rank_combos[j][k][i] = lex_idx;
-					s_three_rank_combos[k][i][j] = lex_idx;
-					s_three_rank_combos[k][j][i] = lex_idx;
+					gen.three_rank_combos[i][j][k] = lex_idx;
+					gen.three_rank_combos[i][k][j] = lex_idx;
+					gen.three_rank_combos[j][i][k] = lex_idx;
+					gen.three_rank_combos[j][k][i] = lex_idx;
+					gen.three_rank_combos[k][i][j] = lex_idx;
+					gen.three_rank_combos[k][j][i] = lex_idx;
 				}
 			}
 		}
+
+		s_three_rank_combos = gen.three_rank_combos;
 		return true;
 	}
 
 	bool LookupTables::load_default_omaha_ranking()
 	{
+		GeneratedTables& gen = generated();
+
 		size_t index = 0;
 
 		// TODO: Temp hard coding
@@ -240,14 +338,20 @@ namespace sim {
 				return false;
 			}
 
-			cmatch::enum_ftr ftr = [&index](Card const cards[], size_t count, size_t lex_index)
+			cmatch::enum_ftr ftr = [&index, &gen](Card const cards[], size_t count, size_t lex_index)
 				{
-					s_default_omaha_ranking[index++] = lex_index;
+					gen.default_omaha_ranking[index++] = lex_index;
 				}
 			;
 		}
 
-		return index == omaha::NUM_STARTING_HANDS;
+		if(index != omaha::NUM_STARTING_HANDS)
+		{
+			return false;
+		}
+
+		s_default_omaha_ranking = gen.default_omaha_ranking.data();
+		return true;
 	}
 
 	size_t LookupTables::omaha_range_by_ranking(omaha::BitsetRange& range, size_t bottom_percent, size_t top_percent)
@@ -269,6 +373,276 @@ namespace sim {
 		return bottom_index - top_index + 1;	// TODO: this means, for example, 5%-5% would be a range of a single hand. Bit weird...
 	}
 
+	bool LookupTables::open_default_matchup_store()
+	{
+		// The store is optional, sims just sample as normal without it
+		boost::optional< string > const filename = get_env(_T("EPW_PREFLOP_MATCHUPS"));
+		PreflopMatchupStore::global().open(filename ? *filename : string(_T("preflop_matchups.bin")));
+		return true;
+	}
+
+	namespace {
+
+		char const BLOB_MAGIC[8] = { 'E', 'P', 'W', 'L', 'K', 'T', 'B', '\0' };
+
+		enum BlobSection {
+			BLOB_OMAHA_HAND_MASKS,
+			BLOB_OMAHA_HAND_CARDS,
+			BLOB_OMAHA_HAND_TR_COMBOS,
+			BLOB_OMAHA_HAND_VALS,
+			BLOB_THREE_RANK_COMBOS,
+			BLOB_OMAHA_RANKING,
+			BLOB_OMAHA_EVAL,
+			BLOB_HOLDEM_EVAL,
+			BLOB_BATCH_EVAL,
+
+			BLOB_SECTION_COUNT,
+		};
+
+		/*! The table each section belongs to */
+		LookupTables::Tables const BLOB_SECTION_TABLES[BLOB_SECTION_COUNT] = {
+			LookupTables::OMAHA_HANDS,
+			LookupTables::OMAHA_HANDS,
+			LookupTables::OMAHA_HANDS,
+			LookupTables::OMAHA_HAND_VALS,
+			LookupTables::THREE_RANK_COMBOS,
+			LookupTables::OMAHA_RANKING,
+			LookupTables::OMAHA_EVAL,
+			LookupTables::HOLDEM_EVAL,
+			LookupTables::BATCH_EVAL,
+		};
+
+		/*!
+		Layout of a blob file. The header is followed by the sections, each starting on a cache line boundary, and each the exact
+		image of the corresponding table. A section with zero size is absent. Any change to the layout of the file or of any table
+		must bump VERSION.
+		*/
+		struct BlobHeader
+		{
+			enum { VERSION = 2 };
+
+			struct Section
+			{
+				uint64_t	offset;
+				uint64_t	size;
+			};
+
+			char		magic[8];
+			uint32_t	version;
+			uint32_t	tables;			// Bits of LookupTables::Tables held
+			uint64_t	file_size;
+			uint64_t	checksum;		// Of everything following the header
+			Section		sections[BLOB_SECTION_COUNT];
+		};
+
+		/*!
+		64 bit FNV-1a, taken a word rather than a byte at a time, since the sections are padded to whole cache lines. Guards
+		against truncated or corrupted files rather than tampering.
+		*/
+		uint64_t blob_checksum(void const* data, uint64_t const size)
+		{
+			uint64_t const* const words = static_cast< uint64_t const* >(data);
+			uint64_t hash = 14695981039346656037ULL;
+			for(uint64_t i = 0; i < size / sizeof(uint64_t); ++i)
+			{
+				hash ^= words[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		inline uint64_t round_to_cache_line(uint64_t const size)
+		{
+			return (size + LookupTables::CACHE_LINE_SIZE - 1) / LookupTables::CACHE_LINE_SIZE * LookupTables::CACHE_LINE_SIZE;
+		}
+
+	}
+
+	uint64_t LookupTables::blob_section_size(size_t const section)
+	{
+		switch(section)
+		{
+		case BLOB_OMAHA_HAND_MASKS:
+			return sizeof(Cardset) * NUM_OMAHA_HANDS;
+		case BLOB_OMAHA_HAND_CARDS:
+			return sizeof(OmahaHand::omaha_cards_t) * NUM_OMAHA_HANDS;
+		case BLOB_OMAHA_HAND_TR_COMBOS:
+			return sizeof(OmahaHand::PaddedTwoRankCombos) * NUM_OMAHA_HANDS;
+		case BLOB_OMAHA_HAND_VALS:
+			return sizeof(HandVal) * NUM_TWO_RANK_COMBOS * NUM_THREE_RANK_COMBOS;
+		case BLOB_THREE_RANK_COMBOS:
+			return sizeof(size_t) * Card::RANK_COUNT * Card::RANK_COUNT * Card::RANK_COUNT;
+		case BLOB_OMAHA_RANKING:
+			return sizeof(size_t) * omaha::NUM_STARTING_HANDS;
+		case BLOB_OMAHA_EVAL:
+			return sizeof(OmahaHandEval::Tables);
+		case BLOB_HOLDEM_EVAL:
+			return sizeof(HoldemHandEval::Tables);
+		case BLOB_BATCH_EVAL:
+			return sizeof(PokerHandEvalBatch::Tables);
+		default:
+			return 0;
+		}
+	}
+
+	bool LookupTables::write_blob(string const& filename)
+	{
+		void const* const data[BLOB_SECTION_COUNT] = {
+			s_omaha_hand_masks,
+			s_omaha_hand_cards,
+			s_omaha_hand_tr_combos,
+			s_omaha_hand_vals,
+			s_three_rank_combos,
+			s_default_omaha_ranking,
+			OmahaHandEval::get_tables(),
+			HoldemHandEval::get_tables(),
+			PokerHandEvalBatch::get_tables(),
+		};
+
+		BlobHeader header = {};
+		std::memcpy(header.magic, BLOB_MAGIC, sizeof(BLOB_MAGIC));
+		header.version = BlobHeader::VERSION;
+
+		// Build the image of everything following the header, which is itself a whole number of cache lines
+		std::vector< uint64_t > body;
+		uint64_t offset = round_to_cache_line(sizeof(BlobHeader));
+		for(size_t s = 0; s < BLOB_SECTION_COUNT; ++s)
+		{
+			if(!s_initialized.test(BLOB_SECTION_TABLES[s]))
+			{
+				continue;
+			}
+
+			uint64_t const size = blob_section_size(s);
+			header.tables |= 1u << BLOB_SECTION_TABLES[s];
+			header.sections[s].offset = offset;
+			header.sections[s].size = size;
+
+			uint64_t const padded = round_to_cache_line(size);
+			size_t const start = body.size();
+			body.resize(start + padded / sizeof(uint64_t), 0);
+			std::memcpy(&body[start], data[s], size);
+			offset += padded;
+		}
+
+		std::vector< char > header_image(round_to_cache_line(sizeof(BlobHeader)), 0);
+		header.file_size = offset;
+		header.checksum = blob_checksum(body.data(), body.size() * sizeof(uint64_t));
+		std::memcpy(header_image.data(), &header, sizeof(header));
+
+		std::ofstream out(epw_to_narrow(filename).c_str(), std::ios::binary | std::ios::trunc);
+		out.write(header_image.data(), header_image.size());
+		out.write(reinterpret_cast< char const* >(body.data()), body.size() * sizeof(uint64_t));
+		return out.good();
+	}
+
+	bool LookupTables::map_blob(string const& filename)
+	{
+		using namespace boost::interprocess;
+
+		// Replacing a mapped blob would invalidate the tables already pointing into it
+		if(s_blob_region.get_address() != nullptr)
+		{
+			return false;
+		}
+
+		try
+		{
+			file_mapping file(epw_to_narrow(filename).c_str(), read_only);
+			mapped_region region(file, read_only);
+
+			char const* const base = static_cast< char const* >(region.get_address());
+			BlobHeader const* const header = reinterpret_cast< BlobHeader const* >(base);
+			uint64_t const header_size = round_to_cache_line(sizeof(BlobHeader));
+			if(region.get_size() < header_size ||
+				std::memcmp(header->magic, BLOB_MAGIC, sizeof(BLOB_MAGIC)) != 0 ||
+				header->version != BlobHeader::VERSION ||
+				header->file_size != region.get_size() ||
+				header->checksum != blob_checksum(base + header_size, header->file_size - header_size))
+			{
+				return false;
+			}
+
+			// Each section must be present exactly when its table is held, and be the size of the table as built
+			for(size_t s = 0; s < BLOB_SECTION_COUNT; ++s)
+			{
+				BlobHeader::Section const& section = header->sections[s];
+				bool const held = (header->tables & (1u << BLOB_SECTION_TABLES[s])) != 0;
+				if(held != (section.size != 0) || (held && (section.size != blob_section_size(s) ||
+					section.offset < header_size || section.offset % CACHE_LINE_SIZE != 0 || section.offset + section.size > header->file_size)))
+				{
+					return false;
+				}
+			}
+
+			s_blob_file.swap(file);
+			s_blob_region.swap(region);
+		}
+		catch(interprocess_exception const&)
+		{
+			return false;
+		}
+
+		char const* const base = static_cast< char const* >(s_blob_region.get_address());
+		BlobHeader const* const header = reinterpret_cast< BlobHeader const* >(base);
+		flags_t const held(header->tables);
+
+		if(held.test(OMAHA_HANDS) && !s_initialized.test(OMAHA_HANDS))
+		{
+			s_omaha_hand_masks = reinterpret_cast< Cardset const* >(base + header->sections[BLOB_OMAHA_HAND_MASKS].offset);
+			s_omaha_hand_cards = reinterpret_cast< OmahaHand::omaha_cards_t const* >(base + header->sections[BLOB_OMAHA_HAND_CARDS].offset);
+			s_omaha_hand_tr_combos = reinterpret_cast< OmahaHand::PaddedTwoRankCombos const* >(base + header->sections[BLOB_OMAHA_HAND_TR_COMBOS].offset);
+			s_initialized.set(OMAHA_HANDS);
+		}
+
+		if(held.test(OMAHA_HAND_VALS) && !s_initialized.test(OMAHA_HAND_VALS))
+		{
+			s_omaha_hand_vals = reinterpret_cast< HandVal const (*)[NUM_THREE_RANK_COMBOS] >(base + header->sections[BLOB_OMAHA_HAND_VALS].offset);
+			s_initialized.set(OMAHA_HAND_VALS);
+		}
+
+		if(held.test(THREE_RANK_COMBOS) && !s_initialized.test(THREE_RANK_COMBOS))
+		{
+			s_three_rank_combos = reinterpret_cast< size_t const (*)[Card::RANK_COUNT][Card::RANK_COUNT] >(base + header->sections[BLOB_THREE_RANK_COMBOS].offset);
+			s_initialized.set(THREE_RANK_COMBOS);
+		}
+
+		if(held.test(OMAHA_RANKING) && !s_initialized.test(OMAHA_RANKING))
+		{
+			s_default_omaha_ranking = reinterpret_cast< size_t const* >(base + header->sections[BLOB_OMAHA_RANKING].offset);
+			s_initialized.set(OMAHA_RANKING);
+		}
+
+		if(held.test(OMAHA_EVAL) && !s_initialized.test(OMAHA_EVAL) &&
+			OmahaHandEval::initialize(*reinterpret_cast< OmahaHandEval::Tables const* >(base + header->sections[BLOB_OMAHA_EVAL].offset)))
+		{
+			s_initialized.set(OMAHA_EVAL);
+		}
+
+		if(held.test(HOLDEM_EVAL) && !s_initialized.test(HOLDEM_EVAL) &&
+			HoldemHandEval::initialize(*reinterpret_cast< HoldemHandEval::Tables const* >(base + header->sections[BLOB_HOLDEM_EVAL].offset)))
+		{
+			s_initialized.set(HOLDEM_EVAL);
+		}
+
+		// Only the tables are mapped, the implementation is still selected for this CPU
+		if(held.test(BATCH_EVAL) && !s_initialized.test(BATCH_EVAL) &&
+			PokerHandEvalBatch::initialize(*reinterpret_cast< PokerHandEvalBatch::Tables const* >(base + header->sections[BLOB_BATCH_EVAL].offset)))
+		{
+			s_initialized.set(BATCH_EVAL);
+		}
+
+		return true;
+	}
+
+	bool LookupTables::map_default_blob()
+	{
+		// The blob is optional, any tables it does not provide are generated as normal
+		boost::optional< string > const filename = get_env(_T("EPW_LOOKUP_TABLES"));
+		map_blob(filename ? *filename : string(_T("lookup_tables.bin")));
+		return true;
+	}
+
 }
 }
 
@@ -9,31 +9,65 @@
 #include "poker_core/range.hpp"
 #include "hand_eval/poker_hand_value.hpp"
 
+#include "gen_util/epw_string.hpp"
+
 #include <array>
 #include <bitset>
+#include <cstdint>
 
 
 namespace epw {
 namespace sim {
 
+	/*!
+	Precomputed tables shared by all sims, set up once per process by initialize().
+
+	All tables other than PREFLOP_MATCHUPS, including those of the OMAHA_EVAL, HOLDEM_EVAL and BATCH_EVAL evaluators, can be
+	serialized by write_blob() into a single binary file, which MAPPED_TABLES then memory maps read only in place of generating them.
+	Concurrent processes mapping the same file share its pages. The file is versioned and checksummed, and is ignored if it does not
+	match this build.
+	*/
 	class LookupTables
 	{
 	public:
 		enum Tables {
+			MAPPED_TABLES,		// Maps whichever tables the default blob file holds, if it exists, before generating any others
 			OMAHA_HANDS,
 			OMAHA_HAND_VALS,
 			THREE_RANK_COMBOS,
 			OMAHA_RANKING,
+			OMAHA_EVAL,			// Direct lookup evaluator tables (OmahaHandEval)
+			HOLDEM_EVAL,		// Direct lookup evaluator tables (HoldemHandEval)
+			BATCH_EVAL,			// Widened tables and implementation selection for PokerHandEvalBatch
+			PREFLOP_MATCHUPS,	// Opens the global PreflopMatchupStore, if a store file exists
 
 			TABLE_COUNT,
 		};
 
 		typedef std::bitset< TABLE_COUNT > flags_t;
 
-		// TODO: All this will need to be rethought for optimal performance
+		enum {
+			CACHE_LINE_SIZE = 64,
+		};
+
+		/*!
+		Types of the precomputed data for each omaha hand. The data for all hands is stored as separate arrays, one per kind, so that a
+		sampling loop which needs just the masks, say, reads nothing else. Entries are sized so that none straddles a cache line.
+		*/
 		struct OmahaHand
 		{
-			typedef omaha::Hand	omaha_cards_t;
+			/*! The 4 cards of a hand, as card indices, in the same order as omaha::Hand. Provides the same operator[] access to Cards. */
+			struct CompactCards
+			{
+				std::array< uint8_t, omaha::CARDS_PER_HAND >	indices;
+
+				inline Card operator[] (size_t const idx) const
+				{
+					return Card((card_t)indices[idx]);
+				}
+			};
+
+			typedef CompactCards	omaha_cards_t;
 
 			struct SuitedTwoRankCombo
 			{
@@ -53,19 +87,31 @@ namespace sim {
 			};
 
 			typedef std::array< SuitedTwoRankCombo, combinations::ct< 4, 2 >::res > two_rank_combos_t;
-			
-			omaha_cards_t		cards;
-			Cardset				mask;
-			two_rank_combos_t	tr_combos;
+
+			/*! Combos padded from 12 to 16 bytes */
+			struct alignas(16) PaddedTwoRankCombos
+			{
+				two_rank_combos_t	combos;
+			};
 		};
 
 		// TODO: Perhaps better to use OmahaHandClass once it is ported over, since for preflop there are substantially less than 52 C 4 unique hands.
 		typedef std::array< size_t, omaha::NUM_STARTING_HANDS > omaha_ranking_t;
 
 
-		static inline OmahaHand const& omaha_hand_data(size_t lex_index)
+		static inline Cardset const& omaha_hand_mask(size_t const lex_index)
 		{
-			return s_all_omaha_hands[lex_index];
+			return s_omaha_hand_masks[lex_index];
+		}
+
+		static inline OmahaHand::omaha_cards_t const& omaha_hand_cards(size_t const lex_index)
+		{
+			return s_omaha_hand_cards[lex_index];
+		}
+
+		static inline OmahaHand::two_rank_combos_t const& omaha_hand_tr_combos(size_t const lex_index)
+		{
+			return s_omaha_hand_tr_combos[lex_index].combos;
 		}
 
 		static inline HandVal const& omaha_hand_value(size_t const two_rank_combo_idx, size_t const three_rank_combo_idx)
@@ -83,25 +129,50 @@ namespace sim {
 	public:
 		static bool initialize(flags_t const& flags);
 
+		/*! Writes every initialized table which can be mapped to a blob file */
+		static bool write_blob(string const& filename);
+
+		/*!
+		Memory maps the tables held by a blob file, for any not already initialized. Returns false if the file is missing or not a
+		valid blob for this build, in which case no tables are mapped. Only one blob can be mapped per process.
+		*/
+		static bool map_blob(string const& filename);
+
 	private:
 		static bool generate_all_omaha_hands();
 		static bool generate_omaha_hand_vals();
 		static bool generate_three_rank_combos();
 		static bool load_default_omaha_ranking();
+		static bool open_default_matchup_store();
+		static bool map_default_blob();
+
+		/*! Size of a table's section in a blob file */
+		static uint64_t blob_section_size(size_t section);
 
 	private:
-		static OmahaHand s_all_omaha_hands[combinations::ct< FULL_DECK_SIZE, 4 >::res];
+		static const size_t NUM_OMAHA_HANDS = combinations::ct< FULL_DECK_SIZE, 4 >::res;
 
 		static const size_t NUM_TWO_RANK_COMBOS = epw::combinations_w_replacement::ct< Card::RANK_COUNT, 2 >::res;		// 91
 		static const size_t NUM_THREE_RANK_COMBOS = epw::combinations_w_replacement::ct< Card::RANK_COUNT, 3 >::res;	// 455
-		
-		static HandVal s_omaha_hand_vals[NUM_TWO_RANK_COMBOS][NUM_THREE_RANK_COMBOS];
+
+		/*! Storage for the tables when generated rather than mapped, allocated on first use */
+		struct GeneratedTables;
+		static GeneratedTables& generated();
+
+		// The tables, pointing into either the generated tables or the mapped blob
+
+		// All indexed by lexical hand index, and aligned to cache lines
+		static Cardset const* s_omaha_hand_masks;
+		static OmahaHand::omaha_cards_t const* s_omaha_hand_cards;
+		static OmahaHand::PaddedTwoRankCombos const* s_omaha_hand_tr_combos;
+
+		static HandVal const (*s_omaha_hand_vals)[NUM_THREE_RANK_COMBOS];
 
 		// TODO: space inefficient way to provide order independent lookup from series of 3 ranks to get to a three rank combo index
 		// can use nested table for this
-		static size_t s_three_rank_combos[Card::RANK_COUNT][Card::RANK_COUNT][Card::RANK_COUNT];
+		static size_t const (*s_three_rank_combos)[Card::RANK_COUNT][Card::RANK_COUNT];
 
-		static omaha_ranking_t s_default_omaha_ranking;
+		static size_t const* s_default_omaha_ranking;
 
 		static flags_t s_initialized;
 	};
@@ -6,7 +6,15 @@
 #include "basic_sim_spec.hpp"
 #include "hand_access_components.hpp"
 #include "lookup_tables.hpp"
+#include "blocker_aware_path_gen.hpp"
 
+#include <boost/align/aligned_allocator.hpp>
+#include <boost/mpl/has_key.hpp>
+#include <boost/mpl/set.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <vector>
 
 
@@ -15,15 +23,43 @@ namespace sim {
 
 	// TODO: perhaps we want to have sim spec split into initial spec and processed spec, where initial spec is the raw info
 	// provided for the simulation, and processed spec takes an initial spec and modifies anything as needed for optimal performance.
+	/*!
+	Spec holding a range for each player, as a list of lexical hand indices.
+
+	Once the ranges are complete, localize_hand_data() copies the data of every hand in them out of the global LookupTables arrays
+	into arrays local to the spec, so that get_hand_data() reads hand data from a compact block. Small ranges then stay in L1/L2
+	rather than being scattered across the global arrays. Each hand is stored once however many ranges contain it, with a list per
+	player mapping the hand's position in the range to its local index, and only the components which the sim reads are copied.
+	*/
 	class MultipleRange_SimSpec: public BasicSimSpec
 	{
 	public:
 		typedef std::vector< size_t > lex_range_t;		// A range specified as a list of lexical hand indices.
-		// TODO: This assumes we'll index into a global all_hands array.
-		// Maybe be better to have option to store locally only the hand info for the union of all players' ranges.
 
 		typedef std::vector< lex_range_t > range_list_t;
-		
+
+	private:
+		template < typename T >
+		struct local_array
+		{
+			typedef std::vector< T, boost::alignment::aligned_allocator< T, LookupTables::CACHE_LINE_SIZE > > type;
+		};
+
+		typedef local_array< Hand_LexIndex::data_t >::type			local_lex_indices_t;
+		typedef local_array< Hand_Mask::data_t >::type				local_masks_t;
+		typedef local_array< Hand_Cards::data_t >::type				local_cards_t;
+		typedef local_array< Hand_TwoRankCombos::data_t >::type		local_tr_combos_t;
+		typedef local_array< uint32_t >::type						local_indices_t;
+
+	public:
+		/*! All of the hand components which can be localized */
+		typedef boost::mpl::set<
+			Hand_LexIndex,
+			Hand_Mask,
+			Hand_Cards,
+			Hand_TwoRankCombos
+			> all_hand_components_t;
+
 	public:
 		inline size_t get_num_players() const
 		{
@@ -41,29 +77,131 @@ namespace sim {
 		template <>
 		inline Hand_LexIndex::data_t const& get_hand_data< Hand_LexIndex >(size_t player, size_t hand_index) const
 		{
-			return m_ranges[player][hand_index];
+			return m_local_lex_indices[local_index(player, hand_index)];
 		}
 
 		template <>
 		inline Hand_Mask::data_t const& get_hand_data< Hand_Mask >(size_t player, size_t hand_index) const
 		{
-			return LookupTables::omaha_hand_data(m_ranges[player][hand_index]).mask;
+			return m_local_masks[local_index(player, hand_index)];
 		}
 
 		template <>
 		inline Hand_Cards::data_t const& get_hand_data< Hand_Cards >(size_t player, size_t hand_index) const
 		{
-			return LookupTables::omaha_hand_data(m_ranges[player][hand_index]).cards;
+			assert(!m_local_cards.empty() && "Hand_Cards not localized");
+			return m_local_cards[local_index(player, hand_index)];
 		}
 
 		template <>
 		inline Hand_TwoRankCombos::data_t const& get_hand_data< Hand_TwoRankCombos >(size_t player, size_t hand_index) const
 		{
-			return LookupTables::omaha_hand_data(m_ranges[player][hand_index]).tr_combos;
+			assert(!m_local_tr_combos.empty() && "Hand_TwoRankCombos not localized");
+			return m_local_tr_combos[local_index(player, hand_index)];
+		}
+
+		/*!
+		Copies the hand data for the union of all players' ranges into the local arrays. Must be called after m_ranges and
+		m_initially_blocked are complete, and before any hand data is read. HandCompList is an mpl set of the components to copy,
+		normally the hand components from required_components<> for the policies in use. Hand_LexIndex and Hand_Mask, which path
+		generation and results read directly from the spec, are always copied. Then builds the data shared by every core's
+		BlockerAware_PathGen.
+		*/
+		template < typename HandCompList >
+		void localize_hand_data()
+		{
+			size_t const num_players = m_ranges.size();
+
+			std::vector< size_t > all_hands;
+			for(size_t p = 0; p < num_players; ++p)
+			{
+				all_hands.insert(all_hands.end(), m_ranges[p].begin(), m_ranges[p].end());
+			}
+			std::sort(all_hands.begin(), all_hands.end());
+			all_hands.erase(std::unique(all_hands.begin(), all_hands.end()), all_hands.end());
+
+			bool const copy_cards = boost::mpl::has_key< HandCompList, Hand_Cards >::value;
+			bool const copy_tr_combos = boost::mpl::has_key< HandCompList, Hand_TwoRankCombos >::value;
+
+			m_local_lex_indices.clear();
+			m_local_masks.clear();
+			m_local_cards.clear();
+			m_local_tr_combos.clear();
+			for(size_t const lex_index: all_hands)
+			{
+				m_local_lex_indices.push_back((Hand_LexIndex::data_t)lex_index);
+				m_local_masks.push_back(LookupTables::omaha_hand_mask(lex_index));
+				if(copy_cards)
+				{
+					m_local_cards.push_back(LookupTables::omaha_hand_cards(lex_index));
+				}
+				if(copy_tr_combos)
+				{
+					m_local_tr_combos.push_back(LookupTables::omaha_hand_tr_combos(lex_index));
+				}
+			}
+
+			m_index_offsets.assign(num_players, 0);
+			m_local_indices.clear();
+			for(size_t p = 0; p < num_players; ++p)
+			{
+				// Players with identical ranges share the same index list
+				size_t q = 0;
+				while(q < p && m_ranges[q] != m_ranges[p])
+				{
+					++q;
+				}
+				if(q < p)
+				{
+					m_index_offsets[p] = m_index_offsets[q];
+					continue;
+				}
+
+				m_index_offsets[p] = m_local_indices.size();
+				for(size_t const lex_index: m_ranges[p])
+				{
+					m_local_indices.push_back((uint32_t)(std::lower_bound(all_hands.begin(), all_hands.end(), lex_index) - all_hands.begin()));
+				}
+			}
+
+			m_blocker_aware_data.build(*this);
+		}
+
+		/*! Copies every hand component */
+		void localize_hand_data()
+		{
+			localize_hand_data< all_hand_components_t >();
+		}
+
+		inline BlockerAware_SharedData const& get_blocker_aware_data() const
+		{
+			return m_blocker_aware_data;
+		}
+
+	private:
+		inline size_t local_index(size_t player, size_t hand_index) const
+		{
+			assert(player < m_index_offsets.size() && "localize_hand_data() not called");
+			return m_local_indices[m_index_offsets[player] + hand_index];
 		}
 
 	public:
 		range_list_t m_ranges;
+
+	private:
+		/*! Offset of each player's list in m_local_indices */
+		std::vector< size_t > m_index_offsets;
+
+		/*! For each player, the local index of each hand in their range */
+		local_indices_t m_local_indices;
+
+		/*! Hand data for the union of all ranges, in lexical order */
+		local_lex_indices_t m_local_lex_indices;
+		local_masks_t m_local_masks;
+		local_cards_t m_local_cards;
+		local_tr_combos_t m_local_tr_combos;
+
+		BlockerAware_SharedData m_blocker_aware_data;
 	};
 
 }
@@ -0,0 +1,302 @@
+// parallel_simulation_core.hpp
+
+#ifndef EPW_PARALLEL_SIMULATION_CORE_H
+#define EPW_PARALLEL_SIMULATION_CORE_H
+
+#include "simulation_core.hpp"
+#include "sim_snapshot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace epw {
+namespace sim {
+
+	/*!
+	Runs a simulation over multiple worker threads. Each worker owns a complete core instance, and therefore its own context,
+	path generator and path traverser, so that the only data shared between threads is the read only simulation specification.
+	Results of the individual workers are merged when requested.
+
+	While run() is in progress, another thread may take snapshots of the merged results so far, and may cancel the run. Cores whose
+	run() can be called repeatedly to add further samples (those with INCREMENTAL set) are run in chunks of CHUNK_SAMPLES, with
+	a worker publishing its results to its SnapshotSlot between chunks when asked, and stopping early if cancelled. Other cores only
+	publish once they have finished, and are instead passed the cancellation flag by run(num_samples, cancelled), to check as they go.
+	Every run starts uncancelled.
+
+	Incremental cores can also be run until a deadline, with each worker checking the clock only once every DEADLINE_CHUNK_SAMPLES,
+	so that the cost of the check is negligible while overshooting the deadline by no more than the time to run one such chunk.
+	*/
+	template <
+		typename Core
+	>
+	class ParallelSimulationCore
+	{
+	public:
+		typedef Core									core_t;
+		typedef typename core_t::sim_spec_t				sim_spec_t;
+		typedef typename core_t::results_t				results_t;
+
+		typedef std::chrono::steady_clock				clock_t;
+
+		enum {
+			CHUNK_SAMPLES = 16 * 1024,
+			DEADLINE_CHUNK_SAMPLES = 1024,
+		};
+
+	public:
+		ParallelSimulationCore(sim_spec_t const& _sim_spec, size_t const _num_workers = default_num_workers()): m_cancelled(false)
+		{
+			size_t const num_workers = std::max< size_t >(_num_workers, 1);
+			for(size_t w = 0; w < num_workers; ++w)
+			{
+				// Heap allocated individually so that workers' mutable state does not share cache lines
+				m_cores.push_back(std::unique_ptr< core_t >(new core_t(_sim_spec)));
+				m_slots.push_back(std::unique_ptr< SnapshotSlot< results_t > >(new SnapshotSlot< results_t >()));
+			}
+		}
+
+		static inline size_t default_num_workers()
+		{
+			size_t const hw = std::thread::hardware_concurrency();
+			return hw > 0 ? hw : 1;
+		}
+
+		inline size_t get_num_workers() const
+		{
+			return m_cores.size();
+		}
+
+		/*! One-time initialization of every worker core */
+		void initialize()
+		{
+			for(size_t w = 0; w < m_cores.size(); ++w)
+			{
+				initialize_core(*m_cores[w], w, std::integral_constant< bool, core_t::PARTITIONED >());
+
+				// Snapshots taken before a worker first publishes see its empty results
+				results_t initial;
+				m_cores[w]->get_results(initial);
+				m_slots[w]->reset(initial);
+			}
+		}
+
+		/*!
+		Runs num_samples, split as evenly as possible across all workers. Blocks until every worker has finished, or until the run is
+		cancelled. Returns false if cancelled.
+		*/
+		bool run(sample_count_t const num_samples)
+		{
+			return run_until(clock_t::time_point::max(), num_samples);
+		}
+
+		/*!
+		Runs until the deadline is reached, or max_samples have been run, or the run is cancelled. Returns false if cancelled.
+		Cores which are not INCREMENTAL ignore the deadline, and run max_samples.
+		*/
+		bool run_until(clock_t::time_point const deadline, sample_count_t const max_samples = std::numeric_limits< sample_count_t >::max())
+		{
+			m_cancelled.store(false, std::memory_order_relaxed);
+			return run_workers(deadline, max_samples);
+		}
+
+		/*!
+		As run(), but with monitor called from a separate thread with a snapshot of the results every interval until the run finishes,
+		and once more at the end. monitor takes results_t const& and returns false to cancel the run.
+		*/
+		template < typename Monitor >
+		bool run_monitored(sample_count_t const num_samples, std::chrono::milliseconds const interval, Monitor monitor)
+		{
+			return run_until_monitored(clock_t::time_point::max(), num_samples, interval, monitor);
+		}
+
+		/*! As run_until(), with monitoring as for run_monitored() */
+		template < typename Monitor >
+		bool run_until_monitored(
+			clock_t::time_point const deadline,
+			sample_count_t const max_samples,
+			std::chrono::milliseconds const interval,
+			Monitor monitor
+			)
+		{
+			// Reset before the monitor starts, so that it cannot cancel a run which then clears the flag
+			m_cancelled.store(false, std::memory_order_relaxed);
+
+			std::mutex mutex;
+			std::condition_variable cv;
+			bool finished = false;
+
+			std::thread monitor_thread([this, interval, &monitor, &mutex, &cv, &finished]
+			{
+				results_t snapshot;
+				std::unique_lock< std::mutex > lock(mutex);
+				while(!cv.wait_for(lock, interval, [&finished] { return finished; }))
+				{
+					lock.unlock();
+					get_snapshot(snapshot);
+					if(!monitor(static_cast< results_t const& >(snapshot)))
+					{
+						cancel();
+					}
+					lock.lock();
+				}
+			});
+
+			run_workers(deadline, max_samples);
+
+			{
+				std::lock_guard< std::mutex > lock(mutex);
+				finished = true;
+			}
+			cv.notify_one();
+			monitor_thread.join();
+
+			results_t final_results;
+			get_results(final_results);
+			monitor(static_cast< results_t const& >(final_results));
+			return !is_cancelled();
+		}
+
+		/*! Merges the results of every worker's path traverser */
+		void get_results(results_t& res) const
+		{
+			m_cores[0]->get_results(res);
+			for(size_t w = 1; w < m_cores.size(); ++w)
+			{
+				results_t worker_res;
+				m_cores[w]->get_results(worker_res);
+				res.combine_with(worker_res);
+			}
+		}
+
+		/*!
+		Merges the most recently published results of every worker into res, without waiting for the workers, and asks each of them
+		to publish afresh. May be called from any thread while run() is in progress. Returns the total number of publications so far,
+		so that a caller polling for progress can tell if anything has changed.
+		*/
+		uint64_t get_snapshot(results_t& res)
+		{
+			std::lock_guard< std::mutex > lock(m_snapshot_mutex);
+
+			uint64_t epoch = m_slots[0]->epoch();
+			res = m_slots[0]->latest();
+			for(size_t w = 1; w < m_slots.size(); ++w)
+			{
+				epoch += m_slots[w]->epoch();
+				res.combine_with(m_slots[w]->latest());
+			}
+			return epoch;
+		}
+
+		/*! Asks all workers to stop at the end of their current chunk, or at the core's next check if not INCREMENTAL. May be called from any thread. */
+		inline void cancel()
+		{
+			m_cancelled.store(true, std::memory_order_relaxed);
+		}
+
+		inline bool is_cancelled() const
+		{
+			return m_cancelled.load(std::memory_order_relaxed);
+		}
+
+	private:
+		bool run_workers(clock_t::time_point const deadline, sample_count_t const max_samples)
+		{
+			size_t const num_workers = m_cores.size();
+
+			std::vector< std::thread > threads;
+			threads.reserve(num_workers - 1);
+			for(size_t w = 1; w < num_workers; ++w)
+			{
+				sample_count_t const worker_samples = samples_for_worker(max_samples, w);
+				threads.push_back(std::thread([this, w, worker_samples, deadline] { run_worker(w, worker_samples, deadline); }));
+			}
+
+			// Calling thread acts as the first worker
+			run_worker(0, samples_for_worker(max_samples, 0), deadline);
+
+			for(std::thread& t: threads)
+			{
+				t.join();
+			}
+			return !is_cancelled();
+		}
+
+		/*! Cores which are PARTITIONED need to know how many cores are sharing the work, others only their own index */
+		inline void initialize_core(core_t& core, size_t const w, std::true_type)
+		{
+			core.initialize(w, m_cores.size());
+		}
+
+		inline void initialize_core(core_t& core, size_t const w, std::false_type)
+		{
+			core.initialize(w);
+		}
+
+		void run_worker(size_t const w, sample_count_t const num_samples, clock_t::time_point const deadline)
+		{
+			core_t& core = *m_cores[w];
+			SnapshotSlot< results_t >& slot = *m_slots[w];
+
+			run_core(core, slot, num_samples, deadline, std::integral_constant< bool, core_t::INCREMENTAL >());
+
+			// Final results are always published, so that the last snapshot of a completed run is complete
+			core.get_results(slot.back_buffer());
+			slot.publish();
+		}
+
+		/*! Incremental cores are run chunk by chunk, publishing and checking for cancellation and the deadline in between */
+		void run_core(core_t& core, SnapshotSlot< results_t >& slot, sample_count_t const num_samples, clock_t::time_point const deadline, std::true_type)
+		{
+			bool const timed = deadline != clock_t::time_point::max();
+			sample_count_t const chunk_samples = timed ? DEADLINE_CHUNK_SAMPLES : CHUNK_SAMPLES;
+
+			sample_count_t done = 0;
+			while(done < num_samples && !is_cancelled() && !(timed && clock_t::now() >= deadline))
+			{
+				sample_count_t const chunk = std::min< sample_count_t >(chunk_samples, num_samples - done);
+				core.run(chunk);
+				done += chunk;
+
+				if(slot.requested())
+				{
+					core.get_results(slot.back_buffer());
+					slot.publish();
+				}
+			}
+		}
+
+		/*! Other cores are run in one go, checking the cancellation flag themselves */
+		void run_core(core_t& core, SnapshotSlot< results_t >& slot, sample_count_t const num_samples, clock_t::time_point const deadline, std::false_type)
+		{
+			core.run(num_samples, m_cancelled);
+		}
+
+		inline sample_count_t samples_for_worker(sample_count_t const num_samples, size_t const worker) const
+		{
+			sample_count_t const num_workers = m_cores.size();
+			return num_samples / num_workers + (worker < num_samples % num_workers ? 1 : 0);
+		}
+
+	private:
+		std::vector< std::unique_ptr< core_t > > m_cores;
+		std::vector< std::unique_ptr< SnapshotSlot< results_t > > > m_slots;
+
+		std::atomic< bool > m_cancelled;
+		std::mutex m_snapshot_mutex;
+	};
+
+}
+}
+
+
+#endif
+
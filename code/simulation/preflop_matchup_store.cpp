@@ -0,0 +1,273 @@
+// preflop_matchup_store.cpp
+
+#include "preflop_matchup_store.hpp"
+
+#include "hand_eval/omaha_hand_eval.hpp"
+
+#include "poker_core/suit_isomorphism.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <thread>
+
+
+namespace epw {
+namespace sim {
+
+	PreflopMatchupStore PreflopMatchupStore::s_global;
+
+	namespace {
+
+		char const STORE_MAGIC[8] = { 'E', 'P', 'W', 'P', 'F', 'M', 'S', '\0' };
+
+		/*! Colexicographical index of a 4 card hand, unique within [0, NUM_STARTING_HANDS) */
+		inline size_t omaha_hand_index(Cardset const& cs)
+		{
+			std::array< Card, omaha::CARDS_PER_HAND > cards;
+			size_t const count = cs.get_cards(cards.data());
+			assert(count == omaha::CARDS_PER_HAND);
+
+			std::array< size_t, omaha::CARDS_PER_HAND > indices;
+			for(size_t i = 0; i < count; ++i)
+			{
+				indices[i] = cards[i].get_index();
+			}
+			std::sort(indices.begin(), indices.end());
+
+			size_t index = 0;
+			for(size_t i = 0; i < count; ++i)
+			{
+				if(indices[i] > i)
+				{
+					index += combinations::calc(indices[i], i + 1);
+				}
+			}
+			return index;
+		}
+
+	}
+
+	bool PreflopMatchupStore::open(string const& filename)
+	{
+		using namespace boost::interprocess;
+
+		close();
+
+		try
+		{
+			file_mapping file(epw_to_narrow(filename).c_str(), read_only);
+			mapped_region region(file, read_only);
+
+			Header const* header = static_cast< Header const* >(region.get_address());
+			if(region.get_size() < sizeof(Header) ||
+				std::memcmp(header->magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 ||
+				header->version != VERSION ||
+				header->bucket_bits == 0 || header->bucket_bits >= 64 ||
+				region.get_size() != sizeof(Header) + ((size_t)1 << header->bucket_bits) * sizeof(Entry))
+			{
+				return false;
+			}
+
+			m_file.swap(file);
+			m_region.swap(region);
+		}
+		catch(interprocess_exception const&)
+		{
+			return false;
+		}
+
+		m_header = static_cast< Header const* >(m_region.get_address());
+		m_entries = reinterpret_cast< Entry const* >(m_header + 1);
+		return true;
+	}
+
+	void PreflopMatchupStore::close()
+	{
+		m_header = nullptr;
+		m_entries = nullptr;
+		boost::interprocess::mapped_region().swap(m_region);
+		boost::interprocess::file_mapping().swap(m_file);
+	}
+
+	size_t PreflopMatchupStore::size() const
+	{
+		return is_open() ? (size_t)m_header->num_entries : 0;
+	}
+
+	bool PreflopMatchupStore::lookup(Cardset const& h1, Cardset const& h2, Matchup& m) const
+	{
+		if(!is_open())
+		{
+			return false;
+		}
+
+		uint64_t const key_12 = matchup_key(h1, h2);
+		uint64_t const key_21 = matchup_key(h2, h1);
+		bool const reversed = key_21 < key_12;
+		uint64_t const key = reversed ? key_21 : key_12;
+
+		// The table is never more than half full, so probing always reaches an empty bucket
+		size_t const mask = ((size_t)1 << m_header->bucket_bits) - 1;
+		for(size_t b = bucket_for_key(key, m_header->bucket_bits); ; b = (b + 1) & mask)
+		{
+			Entry const& e = m_entries[b];
+			if(e.key == key)
+			{
+				m.wins = e.wins;
+				m.ties = e.ties;
+				if(reversed)
+				{
+					m = m.reversed();
+				}
+				return true;
+			}
+			else if(e.key == EMPTY_KEY)
+			{
+				return false;
+			}
+		}
+	}
+
+	bool PreflopMatchupStore::build(std::vector< hand_pair_t > const& matchups, string const& filename, size_t num_threads)
+	{
+		// Reduce to the distinct matchups, each in its stored orientation
+		std::map< uint64_t, hand_pair_t > distinct;
+		for(hand_pair_t const& hp: matchups)
+		{
+			if(hp.first.size() != omaha::CARDS_PER_HAND || hp.second.size() != omaha::CARDS_PER_HAND || hp.first.contains_any(hp.second))
+			{
+				return false;
+			}
+
+			uint64_t const key_12 = matchup_key(hp.first, hp.second);
+			uint64_t const key_21 = matchup_key(hp.second, hp.first);
+			if(key_12 <= key_21)
+			{
+				distinct.insert(std::make_pair(key_12, hp));
+			}
+			else
+			{
+				distinct.insert(std::make_pair(key_21, hand_pair_t(hp.second, hp.first)));
+			}
+		}
+
+		std::vector< uint64_t > keys;
+		std::vector< hand_pair_t > pairs;
+		for(auto const& entry: distinct)
+		{
+			keys.push_back(entry.first);
+			pairs.push_back(entry.second);
+		}
+
+		// Each matchup is independent, so workers just take the next one not yet started
+		size_t const count = pairs.size();
+		std::vector< Matchup > results(count);
+		std::atomic< size_t > next(0);
+		auto worker = [&pairs, &results, &next, count]()
+		{
+			for(size_t i = next++; i < count; i = next++)
+			{
+				results[i] = evaluate_matchup(pairs[i].first, pairs[i].second);
+			}
+		};
+
+		if(num_threads == 0)
+		{
+			num_threads = std::max< size_t >(std::thread::hardware_concurrency(), 1);
+		}
+
+		std::vector< std::thread > threads;
+		for(size_t t = 1; t < num_threads; ++t)
+		{
+			threads.push_back(std::thread(worker));
+		}
+		worker();
+		for(std::thread& t: threads)
+		{
+			t.join();
+		}
+
+		// Size the table to be at most half full
+		Header header = {};
+		std::memcpy(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+		header.version = VERSION;
+		header.bucket_bits = 4;
+		while(((size_t)1 << header.bucket_bits) < 2 * count)
+		{
+			++header.bucket_bits;
+		}
+		header.num_entries = count;
+
+		Entry empty;
+		empty.key = EMPTY_KEY;
+		empty.wins = 0;
+		empty.ties = 0;
+		std::vector< Entry > table((size_t)1 << header.bucket_bits, empty);
+
+		size_t const mask = table.size() - 1;
+		for(size_t i = 0; i < count; ++i)
+		{
+			size_t b = bucket_for_key(keys[i], header.bucket_bits);
+			while(table[b].key != EMPTY_KEY)
+			{
+				b = (b + 1) & mask;
+			}
+
+			table[b].key = keys[i];
+			table[b].wins = results[i].wins;
+			table[b].ties = results[i].ties;
+		}
+
+		std::ofstream out(epw_to_narrow(filename).c_str(), std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast< char const* >(&header), sizeof(header));
+		out.write(reinterpret_cast< char const* >(table.data()), table.size() * sizeof(Entry));
+		return out.good();
+	}
+
+	PreflopMatchupStore::Matchup PreflopMatchupStore::evaluate_matchup(Cardset const& h1, Cardset const& h2)
+	{
+		std::array< Card, omaha::CARDS_PER_HAND > cards_1, cards_2;
+		h1.get_cards(cards_1.data());
+		h2.get_cards(cards_2.data());
+
+		std::array< Cardset, 2 > const hands = {{ h1, h2 }};
+		Cardset const deck = Cardset::FULL_DECK - (h1 | h2);
+
+		Matchup m;
+		suit_iso::enumerate_canonical_subsets(deck, MAX_BOARD_CARDS, hands.data(), hands.size(), [&](Cardset const runout, size_t const weight)
+		{
+			std::array< Card, MAX_BOARD_CARDS > cards;
+			runout.get_cards(cards.data());
+
+			Board board;
+			board.add(cards);
+			OmahaHandEval::BoardKey const key = OmahaHandEval::prepare_board(board);
+
+			HandVal const val_1 = OmahaHandEval::evaluate(cards_1, key);
+			HandVal const val_2 = OmahaHandEval::evaluate(cards_2, key);
+			if(val_1 > val_2)
+			{
+				m.wins += (uint32_t)weight;
+			}
+			else if(val_1 == val_2)
+			{
+				m.ties += (uint32_t)weight;
+			}
+		});
+		return m;
+	}
+
+	uint64_t PreflopMatchupStore::matchup_key(Cardset const& h1, Cardset const& h2)
+	{
+		std::array< Cardset, 2 > hands = {{ h1, h2 }};
+		suit_iso::canonicalize(hands.data(), hands.size(), hands.data());
+		return (uint64_t)omaha_hand_index(hands[0]) * omaha::NUM_STARTING_HANDS + omaha_hand_index(hands[1]);
+	}
+
+}
+}
+
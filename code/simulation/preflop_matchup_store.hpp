@@ -0,0 +1,155 @@
+// preflop_matchup_store.hpp
+/*!
+Store of precomputed exact equities for preflop all-in Omaha matchups between two specific hands.
+
+Matchups are keyed on the suit canonical form (see suit_isomorphism.hpp) of the pair of hands, so one entry serves every suit
+relabelling of the matchup, and a matchup and its reverse share the same entry. Each entry holds the outcome counts over all of the
+possible boards, so results read from the store are exact.
+
+The store is built offline by build() and written to a binary file holding an open addressed hash table, which open() memory maps so
+that the table is used in place without being read in, and lookup() is a single hash probe sequence.
+*/
+
+#ifndef EPW_PREFLOP_MATCHUP_STORE_H
+#define EPW_PREFLOP_MATCHUP_STORE_H
+
+#include "poker_core/cardset.hpp"
+#include "poker_core/board.hpp"
+#include "poker_core/game_properties.hpp"
+
+#include "gen_util/combinatorics.hpp"
+#include "gen_util/epw_string.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+namespace epw {
+namespace sim {
+
+	class PreflopMatchupStore
+	{
+	public:
+		enum {
+			NUM_RUNOUTS = combinations::ct< FULL_DECK_SIZE - 2 * omaha::CARDS_PER_HAND, MAX_BOARD_CARDS >::res,		// 1086008
+
+			// Sims are only answered from the store when neither range has more hands than this
+			MAX_RANGE_HANDS = 64,
+		};
+
+		/*! Outcome counts over all NUM_RUNOUTS boards, from the point of view of the first hand of the matchup */
+		struct Matchup
+		{
+			uint32_t	wins;
+			uint32_t	ties;
+
+			Matchup(): wins(0), ties(0)
+			{}
+
+			inline uint32_t losses() const
+			{
+				return NUM_RUNOUTS - wins - ties;
+			}
+
+			inline double equity() const
+			{
+				return (wins + 0.5 * ties) / NUM_RUNOUTS;
+			}
+
+			/*! The same matchup from the point of view of the second hand */
+			inline Matchup reversed() const
+			{
+				Matchup m;
+				m.wins = losses();
+				m.ties = ties;
+				return m;
+			}
+		};
+
+		typedef std::pair< Cardset, Cardset >	hand_pair_t;
+
+	public:
+		PreflopMatchupStore(): m_header(nullptr), m_entries(nullptr)
+		{}
+
+		/*! Memory maps a store file. Returns false, leaving the store closed, if the file is missing or not a valid store. */
+		bool open(string const& filename);
+		void close();
+
+		inline bool is_open() const
+		{
+			return m_header != nullptr;
+		}
+
+		/*! Number of distinct matchups stored */
+		size_t size() const;
+
+		/*! Looks up the matchup of hand h1 against h2, with m given from h1's point of view. Returns false if not in the store. */
+		bool lookup(Cardset const& h1, Cardset const& h2, Matchup& m) const;
+
+		/*!
+		Calculates exactly, over num_threads worker threads (0 for one per hardware thread), every distinct matchup amongst those
+		given and writes them to a new store file. Requires the OMAHA_EVAL lookup tables.
+		*/
+		static bool build(std::vector< hand_pair_t > const& matchups, string const& filename, size_t num_threads = 0);
+
+		/*! Exact outcome counts for h1 against h2, visiting one board from each suit isomorphic class */
+		static Matchup evaluate_matchup(Cardset const& h1, Cardset const& h2);
+
+		/*! The store consulted by range equity sims, opened by LookupTables::initialize() */
+		static inline PreflopMatchupStore& global()
+		{
+			return s_global;
+		}
+
+	private:
+		struct Header
+		{
+			char		magic[8];
+			uint32_t	version;
+			uint32_t	bucket_bits;	// The table has 2 ^ bucket_bits buckets
+			uint64_t	num_entries;
+		};
+
+		struct Entry
+		{
+			uint64_t	key;
+			uint32_t	wins;
+			uint32_t	ties;
+		};
+
+		enum {
+			VERSION = 1,
+		};
+
+		static const uint64_t EMPTY_KEY = ~0ull;
+
+		/*! Key of the matchup from h1's point of view. The stored orientation of a matchup is the one with the lower key. */
+		static uint64_t matchup_key(Cardset const& h1, Cardset const& h2);
+
+		static inline size_t bucket_for_key(uint64_t const key, uint32_t const bucket_bits)
+		{
+			// Fibonacci hashing
+			return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - bucket_bits));
+		}
+
+	private:
+		boost::interprocess::file_mapping		m_file;
+		boost::interprocess::mapped_region		m_region;
+
+		Header const*	m_header;
+		Entry const*	m_entries;
+
+		static PreflopMatchupStore	s_global;
+	};
+
+}
+}
+
+
+#endif
+
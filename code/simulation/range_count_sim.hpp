@@ -7,9 +7,14 @@
 #include "sim_results.hpp"
 
 #include "gen_util/combinatorics.hpp"	// TODO: as above
+#include "gen_util/bit_ops.hpp"
 
+#include <boost/dynamic_bitset.hpp>
+#include <boost/mpl/set.hpp>
+
+#include <cassert>
+#include <cstdint>
 #include <vector>
-#include <bitset>	// TODO: remove when replace with omaha range type
 
 
 namespace epw {
@@ -17,27 +22,73 @@ namespace sim {
 
 	/*!
 	An extension to the basic simulation state class for counting subranges.
+
+	Membership of the subranges is precomputed for every hand in each player's range, as a mask with bit sr set if the hand is in
+	subrange sr, held in get_membership_words() words per hand so that any number of subranges is supported.
 	*/
 	class RangeCountSim_Spec: public MultipleRange_SimSpec
 	{
 	public:
-		typedef std::bitset< combinations::ct< FULL_DECK_SIZE, 4 >::res > subrange_t;
+		/*! A subrange, as a bitset over the lexicographical indices of all omaha hands */
+		typedef boost::dynamic_bitset<> lex_subrange_t;
+
+		typedef uint64_t membership_word_t;
+
+		enum {
+			MEMBERSHIP_WORD_BITS = 64,
+		};
+
+	public:
+		/*! Sets a player's subranges. Must be called after the player's range has been set. */
+		void set_subranges(size_t player, std::vector< lex_subrange_t > const& subranges)
+		{
+			if(m_num_subranges.size() <= player)
+			{
+				m_num_subranges.resize(player + 1, 0);
+				m_membership.resize(player + 1);
+			}
+
+			size_t const num_subranges = subranges.size();
+			size_t const num_words = (num_subranges + MEMBERSHIP_WORD_BITS - 1) / MEMBERSHIP_WORD_BITS;
+			lex_range_t const& range = m_ranges[player];
+
+			m_num_subranges[player] = num_subranges;
+			m_membership[player].assign(range.size() * num_words, 0);
+			for(size_t h = 0; h < range.size(); ++h)
+			{
+				membership_word_t* const words = &m_membership[player][h * num_words];
+				for(size_t sr = 0; sr < num_subranges; ++sr)
+				{
+					assert(subranges[sr].size() == (combinations::ct< FULL_DECK_SIZE, 4 >::res));
+					if(subranges[sr].test(range[h]))
+					{
+						words[sr / MEMBERSHIP_WORD_BITS] |= (membership_word_t)1 << (sr % MEMBERSHIP_WORD_BITS);
+					}
+				}
+			}
+		}
 
 		inline size_t get_num_subranges(size_t player) const
 		{
-			return m_subranges[player].size();
+			return player < m_num_subranges.size() ? m_num_subranges[player] : 0;
 		}
 
-		inline subrange_t const& get_subrange(size_t player, size_t sr_idx) const
+		inline size_t get_membership_words(size_t player) const
 		{
-			return m_subranges[player][sr_idx];
+			return (get_num_subranges(player) + MEMBERSHIP_WORD_BITS - 1) / MEMBERSHIP_WORD_BITS;
 		}
 
-	public:
-		typedef std::vector< subrange_t > player_subranges_t;
-		typedef std::vector< player_subranges_t > all_subranges_t;
+		/*! Subrange membership mask of the hand at the given index into the player's range */
+		inline membership_word_t const* get_membership(size_t player, size_t hand_index) const
+		{
+			return &m_membership[player][hand_index * get_membership_words(player)];
+		}
+
+	protected:
+		std::vector< size_t > m_num_subranges;
 
-		all_subranges_t m_subranges;
+		/*! [player][hand index * membership words + word] */
+		std::vector< std::vector< membership_word_t > > m_membership;
 	};
 
 	/*!
@@ -46,22 +97,71 @@ namespace sim {
 	class RangeCountSim_PathTraversal
 	{
 	public:
+		typedef boost::mpl::set0<
+			> req_hand_subcomponents_t;
+
+		typedef boost::mpl::set0<
+			> req_board_subcomponents_t;
+
 		typedef std::vector< size_t >				subrange_counts_t;
 
 		struct results_t:
 			public SimResultsBase,
 			public std::vector< subrange_counts_t >
-		{};
+		{
+			inline void combine_with(results_t const& other)
+			{
+				SimResultsBase::combine_with(other);
+
+				assert(size() == other.size());
+				for(size_t p = 0; p < size(); ++p)
+				{
+					assert((*this)[p].size() == other[p].size());
+					for(size_t sr = 0; sr < (*this)[p].size(); ++sr)
+					{
+						(*this)[p][sr] += other[p][sr];
+					}
+				}
+			}
+
+			/*! Frequency of a player's subrange */
+			inline Estimate get_estimate(size_t const p, size_t const sr) const
+			{
+				return estimate_from_count((*this)[p][sr], num_samples);
+			}
+
+			inline double get_max_std_err() const
+			{
+				double max_err = 0.0;
+				for(size_t p = 0; p < size(); ++p)
+				{
+					for(size_t sr = 0; sr < (*this)[p].size(); ++sr)
+					{
+						max_err = std::max(max_err, get_estimate(p, sr).std_err);
+					}
+				}
+				return max_err;
+			}
+		};
 
 	public:
+		RangeCountSim_PathTraversal(): m_spec(nullptr)
+		{}
+
 		template < typename SimSpec >
 		void initialize(SimSpec const& spec)
 		{
+			m_spec = &spec;
+
 			size_t const num_players = spec.get_num_players();
 			m_counts.resize(num_players);
+			m_hand_counts.resize(num_players);
 			for(size_t i = 0; i < num_players; ++i)
 			{
 				m_counts[i].resize(spec.get_num_subranges(i), 0);
+
+				// Players with no subranges need not be counted at all
+				m_hand_counts[i].assign(spec.get_num_subranges(i) > 0 ? spec.get_player_range_size(i) : 0, 0);
 			}
 		}
 
@@ -71,23 +171,48 @@ namespace sim {
 			size_t const num_players = spec.get_num_players();
 			for(size_t i = 0; i < num_players; ++i)
 			{
-				for(size_t sr = 0; sr < spec.get_num_subranges(i); ++sr)
+				if(!m_hand_counts[i].empty())
 				{
-					if(spec.get_subrange(i, sr).test(path_state.get_current_hand_data< Hand_LexIndex >(i)))
-					{
-						++m_counts[i][sr];
-					}
+					++m_hand_counts[i][path_state.get_current_hand_index(i)];
 				}
 			}
 
 			++m_counts.num_samples;
 		}
 
+		/*! Subrange counts are accumulated from the per hand counts only here, so sampling never touches the membership masks */
 		inline void get_results(results_t& res) const
 		{
 			res = m_counts;
+			for(size_t p = 0; p < m_hand_counts.size(); ++p)
+			{
+				size_t const num_words = m_spec->get_membership_words(p);
+				for(size_t h = 0; h < m_hand_counts[p].size(); ++h)
+				{
+					size_t const count = m_hand_counts[p][h];
+					if(count == 0)
+					{
+						continue;
+					}
+
+					RangeCountSim_Spec::membership_word_t const* const words = m_spec->get_membership(p, h);
+					for(size_t w = 0; w < num_words; ++w)
+					{
+						for(uint64_t bits = words[w]; bits != 0; bits = clear_lowest_bit(bits))
+						{
+							res[p][w * RangeCountSim_Spec::MEMBERSHIP_WORD_BITS + lowest_bit_index(bits)] += count;
+						}
+					}
+				}
+			}
 		}
 
+	protected:
+		RangeCountSim_Spec const* m_spec;
+
+		/*! [player][hand index] Number of samples in which the player was dealt each hand of their range */
+		std::vector< std::vector< size_t > > m_hand_counts;
+
 	protected:
 		results_t m_counts;
 	};
@@ -5,11 +5,20 @@
 
 #include "multiple_range_and_board_sim_spec.hpp"
 #include "sim_board_gen.hpp"			// TODO: remove when templatize this
-#include "sim_handeval_bitmask.hpp"		// same
 #include "sim_handeval_lookup.hpp"		// same
 #include "sim_results.hpp"
+#include "batched_simulation_core.hpp"
 
 #include "hand_eval/showdown_outcome.hpp"
+#include "hand_eval/omaha_hand_eval.hpp"
+#include "gen_util/bit_ops.hpp"
+#include "gen_util/prefetch.hpp"
+
+#include <boost/mpl/set.hpp>
+
+#include <array>
+#include <cassert>
+#include <vector>
 
 
 namespace epw {
@@ -21,10 +30,224 @@ namespace sim {
 	class RangeEquitySim_Spec: public MR_Board_SimSpec
 	{
 	public:
+		RangeEquitySim_Spec(): m_breakdown_player(0)
+		{}
+
+	public:
+		/*! Player whose equity is broken down by hand, when running with RangeEquitySim_HandBreakdownResults */
+		size_t m_breakdown_player;
+	};
+
+	/*!
+	Range equity results, as counts of the showdown outcomes of all paths, with the players tied for first ranked First and all other
+	players NullPosition.
+	*/
+	template < typename OutcomeType >
+	struct RangeEquitySim_Results:
+		public SimResultsBase,
+		public showdown_outcome_map_sel< OutcomeType >::type
+	{
+		typedef OutcomeType											outcome_t;
+		typedef typename showdown_outcome_map_sel< outcome_t >::type	oc_map_t;
+
+		size_t num_players;
+
+		RangeEquitySim_Results(): num_players(0)
+		{}
+
+		template < typename SimSpec >
+		void initialize(SimSpec const& spec)
+		{
+			num_players = spec.get_num_players();
+		}
+
+		inline void combine_with(RangeEquitySim_Results const& other)
+		{
+			SimResultsBase::combine_with(other);
+			oc_map_t::combine_with(other);
+		}
+
+		/*! Outcome in which the players in the winners bitmask tie for first */
+		static inline outcome_t winners_outcome(uint32_t winners)
+		{
+			outcome_t oc = outcome_t(outcome_t::player_rank_outcome::get(lowest_bit_index(winners), 0));
+			for(winners = (uint32_t)clear_lowest_bit(winners); winners != 0; winners = (uint32_t)clear_lowest_bit(winners))
+			{
+				// Zero out this player's rank bits, tied first = 0
+				oc &= outcome_t::player_complement::get(lowest_bit_index(winners));
+			}
+			return oc;
+		}
+
+		/*!
+		Records weight equivalent samples with the given winners. hand_index(p) gives the position in player p's range of the hand they
+		were dealt.
+		*/
+		template < typename HandIndexFtr >
+		inline void record(uint32_t const winners, HandIndexFtr const& hand_index, uint64_t const weight = 1)
+		{
+			this->incr(winners_outcome(winners), weight);
+			num_samples += weight;
+		}
+
+		/*! Equity of a player, with the pot shared equally between the players tied for first */
+		inline Estimate get_player_equity(size_t const p) const
+		{
+			double sum = 0.0;
+			double sum_sq = 0.0;
+			for(auto it = this->begin(); it != this->end(); ++it)
+			{
+				outcome_t const oc = this->get_oc(it);
+				if(oc.get_player_rank(p) == 0)
+				{
+					double const share = 1.0 / oc.get_player_count_at_rank(0);
+					double const count = (double)this->get_oc_count(it);
+					sum += count * share;
+					sum_sq += count * share * share;
+				}
+			}
+			return this->estimate_from_sums(sum, sum_sq, num_samples);
+		}
+
+		inline double get_max_std_err() const
+		{
+			double max_err = 0.0;
+			for(size_t p = 0; p < num_players; ++p)
+			{
+				max_err = std::max(max_err, get_player_equity(p).std_err);
+			}
+			return max_err;
+		}
+	};
+
+	/*! Player count independent results, as stored by the simulation front end */
+	typedef RangeEquitySim_Results< generic_sd_outcome > RangeEquitySim_GenericResults;
+
+	/*! Converts the results of a simulation with a fixed player count into generic form */
+	template < size_t PlayerCount >
+	inline void to_generic_results(RangeEquitySim_Results< showdown_outcome< PlayerCount > > const& src, RangeEquitySim_GenericResults& dest)
+	{
+		dest = RangeEquitySim_GenericResults();
+		static_cast< SimResultsBase& >(dest) = src;
+		dest.num_players = src.num_players;
+
+		std::array< size_t, PlayerCount > seats;
+		for(size_t p = 0; p < PlayerCount; ++p)
+		{
+			seats[p] = p;
+		}
+
+		for(auto it = src.begin(); it != src.end(); ++it)
+		{
+			uint64_t const count = src.get_oc_count(it);
+			if(count > 0)
+			{
+				dest.incr(generic_sd_outcome(src.get_oc(it), seats), count);
+			}
+		}
+	}
+
+	/*!
+	Range equity results along with the equity of every individual hand in one player's range, accumulated in flat arrays indexed by
+	the hand's position in the range. Ties are counted separately from outright wins, along with the share of the pot they were worth.
+	*/
+	template < typename OutcomeType >
+	struct RangeEquitySim_HandBreakdownResults: public RangeEquitySim_Results< OutcomeType >
+	{
+		typedef RangeEquitySim_Results< OutcomeType >	base_t;
+
+		size_t							player;			// Player whose range is broken down
+		std::vector< uint32_t >			hands;			// Lexical index of each hand in the player's range
+		std::vector< uint64_t >			samples;
+		std::vector< uint64_t >			wins;
+		std::vector< uint64_t >			ties;
+		std::vector< double >			tie_shares;		// Sum over ties of the fraction of the pot won
+		std::vector< double >			tie_shares_sq;
+
+		RangeEquitySim_HandBreakdownResults(): player(0)
+		{}
+
+		template < typename SimSpec >
+		void initialize(SimSpec const& spec)
+		{
+			base_t::initialize(spec);
+
+			player = spec.m_breakdown_player;
+			size_t const range_size = spec.get_player_range_size(player);
+			hands.resize(range_size);
+			for(size_t h = 0; h < range_size; ++h)
+			{
+				hands[h] = spec.get_hand_data< Hand_LexIndex >(player, h);
+			}
+			samples.assign(range_size, 0);
+			wins.assign(range_size, 0);
+			ties.assign(range_size, 0);
+			tie_shares.assign(range_size, 0.0);
+			tie_shares_sq.assign(range_size, 0.0);
+		}
+
+		inline void combine_with(RangeEquitySim_HandBreakdownResults const& other)
+		{
+			base_t::combine_with(other);
+			for(size_t h = 0; h < samples.size(); ++h)
+			{
+				samples[h] += other.samples[h];
+				wins[h] += other.wins[h];
+				ties[h] += other.ties[h];
+				tie_shares[h] += other.tie_shares[h];
+				tie_shares_sq[h] += other.tie_shares_sq[h];
+			}
+		}
+
+		template < typename HandIndexFtr >
+		inline void record(uint32_t const winners, HandIndexFtr const& hand_index, uint64_t const weight = 1)
+		{
+			base_t::record(winners, hand_index, weight);
+
+			size_t const h = hand_index(player);
+			samples[h] += weight;
+			if(winners == (1u << player))
+			{
+				wins[h] += weight;
+			}
+			else if(winners & (1u << player))
+			{
+				double const share = 1.0 / popcount(winners);
+				ties[h] += weight;
+				tie_shares[h] += weight * share;
+				tie_shares_sq[h] += weight * share * share;
+			}
+		}
+
+		/*! Equity of the hand at position h of the player's range */
+		inline Estimate get_hand_equity(size_t const h) const
+		{
+			return this->estimate_from_sums(wins[h] + tie_shares[h], wins[h] + tie_shares_sq[h], (size_t)samples[h]);
+		}
 	};
 
+	typedef RangeEquitySim_HandBreakdownResults< generic_sd_outcome > RangeEquitySim_GenericHandBreakdownResults;
+
+	/*! Converts the results of a simulation with a fixed player count into generic form */
+	template < size_t PlayerCount >
+	inline void to_generic_results(
+		RangeEquitySim_HandBreakdownResults< showdown_outcome< PlayerCount > > const& src,
+		RangeEquitySim_GenericHandBreakdownResults& dest
+		)
+	{
+		to_generic_results(static_cast< RangeEquitySim_Results< showdown_outcome< PlayerCount > > const& >(src), static_cast< RangeEquitySim_GenericResults& >(dest));
+		dest.player = src.player;
+		dest.hands = src.hands;
+		dest.samples = src.samples;
+		dest.wins = src.wins;
+		dest.ties = src.ties;
+		dest.tie_shares = src.tie_shares;
+		dest.tie_shares_sq = src.tie_shares_sq;
+	}
+
 	/*!
-	A path traversal class for range equity calc.
+	A path traversal class for range equity calc. PlayerCount must equal the number of players in the sim spec, and determines the
+	showdown outcome type, so that with few players outcomes are counted in a flat array rather than a hash map.
 	*/
 	template <
 		size_t PlayerCount
@@ -32,20 +255,27 @@ namespace sim {
 	class RangeEquitySim_PathTraversal
 	{
 	public:
-		typedef generic_sd_outcome outcome_t;
-		//typedef showdown_outcome< PlayerCount > outcome_t;
-		typedef typename showdown_outcome_map_sel< outcome_t >::type oc_map_t;
-		
-		struct results_t:
-			public SimResultsBase,
-			public oc_map_t
-		{};
+		typedef showdown_outcome< PlayerCount > outcome_t;
+		typedef RangeEquitySim_Results< outcome_t > results_t;
+
+		typedef HandEval_BoardRankPairLookup hand_eval_t;
+
+		typedef hand_eval_t::req_hand_subcomponents_t req_hand_subcomponents_t;
+		typedef hand_eval_t::req_board_subcomponents_t req_board_subcomponents_t;
 
 	public:
 		template < typename SimSpec >
 		void initialize(SimSpec const& spec)
 		{
 			m_outcomes = results_t();
+			m_outcomes.initialize(spec);
+		}
+
+		/*! Number of cards that must be dealt to complete the board on each path */
+		template < typename SimSpec >
+		static inline size_t board_cards_needed(SimSpec const& spec)
+		{
+			return MAX_BOARD_CARDS - spec.m_initial_board.count;
 		}
 
 		template < typename SimSpec, typename SimContext, typename PathState >
@@ -54,47 +284,37 @@ namespace sim {
 			// TODO: Feels like for a simple equity sim, board runout belongs rather in path generation, since we know we will
 			// always be doing it. But since this isn't the case for all more complex sims, probably not really achieving anything
 			// by making a special case.
-			BasicBoardGen::runout_board(MAX_BOARD_CARDS - spec.m_initial_board.count, context, path_state);
+			LiveDeckBoardGen::runout_board(board_cards_needed(spec), context, path_state);
+
+			evaluate_path(spec, context, path_state);
+		}
 
-			outcome_t oc;
-/*			if(PlayerCount == 2)
+		/*! Records the showdown outcome of a path whose board is already complete, standing for weight equivalent paths */
+		template < typename SimSpec, typename SimContext, typename PathState >
+		inline void	evaluate_path(SimSpec const& spec, SimContext& context, PathState& path_state, uint64_t const weight = 1)
+		{
+			assert(spec.get_num_players() == PlayerCount);
+
+			HandVal best = hand_eval_t::evaluate_player_hand(0, path_state);
+			uint32_t winners = 1;
+			for(size_t p = 1; p < PlayerCount; ++p)
 			{
-				HandVal const hv1 = HandEval_RankComboLookup::evaluate_player_hand(0, path_state);
-				HandVal const hv2 = HandEval_RankComboLookup::evaluate_player_hand(1, path_state);
-				oc = hv1 > hv2 ? 2 : (hv1 < hv2 ? 1 : 0);
-			}
-			else
-*/			{
-				HandVal best = HandEval_RankComboLookup::evaluate_player_hand(0, path_state);
-				std::vector< size_t > winners(1, (size_t)0);
-				for(size_t p = 1; p < spec.get_num_players(); ++p)
+				HandVal const val = hand_eval_t::evaluate_player_hand(p, path_state);
+				if(val > best)
 				{
-					HandVal val = HandEval_RankComboLookup::evaluate_player_hand(p, path_state);
-					if(val > best)
-					{
-						best = val;
-						winners.clear();
-						winners.push_back(p);
-					}
-					else if(val == best)
-					{
-						winners.push_back(p);
-					}
+					best = val;
+					winners = 1 << p;
 				}
-
-				oc = outcome_t(outcome_t::player_rank_outcome::get(winners.front(), 0));
-				for(size_t i = 1; i < winners.size(); ++i)
+				else if(val == best)
 				{
-					// Zero out this player's rank bits
-					oc &= outcome_t::player_complement::get(winners[i]);
-					// And or in their position (1st)
-					// not needed since tied first = 0				oc |= outcome_t::player_rank::get(winners[i], 0);
+					winners |= 1 << p;
 				}
 			}
 
-			m_outcomes.incr(oc, 1);
+			outcome_t const oc = results_t::winners_outcome(winners);
+			m_outcomes.incr(oc, weight);
 
-			++m_outcomes.num_samples;
+			m_outcomes.num_samples += weight;
 		}
 
 		inline void get_results(results_t& res) const
@@ -106,6 +326,150 @@ namespace sim {
 		results_t m_outcomes;
 	};
 
+	/*!
+	A batch traversal class for range equity calc, for use with BatchedSimulationCore. Each batch is evaluated in stages: first an
+	evaluation key for every path's board, then every path's hand value for one player at a time from the hand's precomputed two card
+	combos, prefetching these a few paths ahead since hands are scattered throughout the lookup tables, and finally the showdown
+	outcomes.
+
+	Paths held in a BatchPathState can also be evaluated individually, for use with EnumerationCore. Results may be any of the range
+	equity results types for PlayerCount players.
+	*/
+	template <
+		size_t PlayerCount,
+		typename Results = RangeEquitySim_Results< showdown_outcome< PlayerCount > >
+	>
+	class RangeEquitySim_BatchTraversal
+	{
+	public:
+		typedef RangeEquitySim_PathTraversal< PlayerCount >		path_traversal_t;
+		typedef showdown_outcome< PlayerCount >					outcome_t;
+		typedef Results											results_t;
+
+		// Hand components read from the spec. Boards are evaluated from BatchPathState, so need no components.
+		typedef typename path_traversal_t::req_hand_subcomponents_t	req_hand_subcomponents_t;
+		typedef boost::mpl::set0<>									req_board_subcomponents_t;
+
+		enum {
+			PREFETCH_DISTANCE = 8,
+		};
+
+	public:
+		template < typename SimSpec >
+		static inline size_t board_cards_needed(SimSpec const& spec)
+		{
+			return path_traversal_t::board_cards_needed(spec);
+		}
+
+		template < typename SimSpec >
+		void initialize(SimSpec const& spec)
+		{
+			m_outcomes = results_t();
+			m_outcomes.initialize(spec);
+		}
+
+		template < typename SimSpec, typename SimContext >
+		void traverse_batch(SimSpec const& spec, SimContext& context, PathBatch const& batch)
+		{
+			evaluate_batch_hands(spec, batch);
+
+			for(size_t k = 0; k < batch.count; ++k)
+			{
+				uint32_t const winners = best_hands(&m_vals[k], batch.capacity);
+				m_outcomes.record(winners, [&batch, k](size_t const p){ return batch.player_hands(p)[k]; });
+			}
+		}
+
+		/*! Records the showdown outcome of a single path whose board is already complete, standing for weight equivalent paths */
+		template < typename SimSpec, typename SimContext >
+		inline void evaluate_path(SimSpec const& spec, SimContext& context, BatchPathState const& path_state, uint64_t const weight = 1)
+		{
+			std::array< HandVal, PlayerCount > vals;
+			evaluate_path_hands(spec, path_state, vals.data());
+
+			uint32_t const winners = best_hands(vals.data(), 1);
+			m_outcomes.record(winners, [&path_state](size_t const p){ return path_state.hands[p]; }, weight);
+		}
+
+		inline void get_results(results_t& res) const
+		{
+			res = m_outcomes;
+		}
+
+	protected:
+		/*! Fills m_vals with every player's hand value on every path of the batch */
+		template < typename SimSpec >
+		void evaluate_batch_hands(SimSpec const& spec, PathBatch const& batch)
+		{
+			size_t const count = batch.count;
+			assert(spec.get_num_players() == PlayerCount);
+
+			m_keys.resize(batch.capacity);
+			m_vals.resize(PlayerCount * batch.capacity);
+
+			for(size_t k = 0; k < count; ++k)
+			{
+				m_keys[k] = OmahaHandEval::prepare_board(batch.boards[k]);
+			}
+
+			for(size_t p = 0; p < PlayerCount; ++p)
+			{
+				uint32_t const* const hands = batch.player_hands(p);
+				HandVal* const vals = &m_vals[p * batch.capacity];
+				for(size_t k = 0; k < count; ++k)
+				{
+					if(k + PREFETCH_DISTANCE < count)
+					{
+						prefetch(&spec.get_hand_data< Hand_TwoRankCombos >(p, hands[k + PREFETCH_DISTANCE]));
+					}
+
+					vals[k] = OmahaHandEval::evaluate_combos(spec.get_hand_data< Hand_TwoRankCombos >(p, hands[k]), m_keys[k]);
+				}
+			}
+		}
+
+		/*! Writes every player's hand value on a single path whose board is already complete to vals */
+		template < typename SimSpec >
+		static inline void evaluate_path_hands(SimSpec const& spec, BatchPathState const& path_state, HandVal vals[])
+		{
+			assert(spec.get_num_players() == PlayerCount);
+
+			OmahaHandEval::BoardKey const key = OmahaHandEval::prepare_board(path_state.board);
+			for(size_t p = 0; p < PlayerCount; ++p)
+			{
+				vals[p] = OmahaHandEval::evaluate_combos(spec.get_hand_data< Hand_TwoRankCombos >(p, path_state.hands[p]), key);
+			}
+		}
+
+		/*! Bitmask of the players holding the best hand, given each player's hand value stride apart */
+		static inline uint32_t best_hands(HandVal const vals[], size_t const stride)
+		{
+			HandVal best = vals[0];
+			uint32_t winners = 1;
+			for(size_t p = 1; p < PlayerCount; ++p)
+			{
+				HandVal const val = vals[p * stride];
+				if(val > best)
+				{
+					best = val;
+					winners = 1 << p;
+				}
+				else if(val == best)
+				{
+					winners |= 1 << p;
+				}
+			}
+			return winners;
+		}
+
+	protected:
+		results_t m_outcomes;
+
+		/*! Per batch working storage */
+		std::vector< OmahaHandEval::BoardKey > m_keys;
+		std::vector< HandVal > m_vals;		// [player * capacity + path]
+	};
+
 }
 }
 
@@ -3,11 +3,10 @@
 #ifndef EPW_RANGE_TUPLE_PATH_GEN_H
 #define EPW_RANGE_TUPLE_PATH_GEN_H
 
-#include "poker_core/cardset.hpp"
-
-#include <boost/random/uniform_int_distribution.hpp>
+#include "required_components.hpp"
 
-#include <vector>
+#include "poker_core/cardset.hpp"
+#include "gen_util/xoshiro.hpp"
 
 
 namespace epw {
@@ -16,19 +15,14 @@ namespace sim {
 	/*!
 	A path generation policy class implementation to select a random hand tuple from given ranges.
 	This will be the path gen for the majority of epw simulation types.
+	Hands are read from the sim spec and the path state's deck only, so no hand or board components are required.
 	*/
-	class RangeTuple_PathGen
+	class RangeTuple_PathGen: public NoRequiredComponents
 	{
 	public:
 		template < typename SimSpec >
 		void initialize(SimSpec const& spec)
-		{
-			const size_t num_players = spec.get_num_players();
-			for(size_t i = 0; i < num_players; ++i)
-			{
-				m_hand_dists.push_back(hand_dist_t(0, spec.get_player_range_size(i) - 1));
-			}
-		}
+		{}
 
 		template < typename SimSpec, typename SimContext, typename PathState >
 		void generate_path(SimSpec const& spec, SimContext& context, PathState& path_state) const
@@ -40,7 +34,7 @@ namespace sim {
 				size_t const num_players = spec.get_num_players();
 				for(size_t i = 0; i < num_players; ++i)
 				{
-					int const sel_hand = m_hand_dists[i](context.gen);
+					size_t const sel_hand = (size_t)rand_below(context.gen, spec.get_player_range_size(i));
 
 					Cardset const hand_mask = spec.get_hand_data< Hand_Mask >(i, sel_hand);
 					if(hand_mask.contains_any(blocked))
@@ -64,11 +58,6 @@ namespace sim {
 				}
 			}
 		}
-
-	protected:
-		typedef boost::random::uniform_int_distribution<>			hand_dist_t;
-		
-		std::vector< hand_dist_t > m_hand_dists;
 	};
 
 }
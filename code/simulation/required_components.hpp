@@ -0,0 +1,76 @@
+// required_components.hpp
+/*!
+Derives the hand and board components which a path state needs to maintain from the policies which will read them.
+Each path generation, path traversal and hand evaluation policy declares the components it reads as the mpl sets
+req_hand_subcomponents_t and req_board_subcomponents_t, and the hand and board access policies are instantiated with the union
+of these, so that no component is updated per sample unless something reads it.
+*/
+
+#ifndef EPW_REQUIRED_COMPONENTS_H
+#define EPW_REQUIRED_COMPONENTS_H
+
+#include <boost/mpl/fold.hpp>
+#include <boost/mpl/insert.hpp>
+#include <boost/mpl/set.hpp>
+#include <boost/mpl/placeholders.hpp>
+
+
+namespace epw {
+namespace sim {
+
+	/*! For policies which read no hand or board components */
+	struct NoRequiredComponents
+	{
+		typedef boost::mpl::set0<> req_hand_subcomponents_t;
+		typedef boost::mpl::set0<> req_board_subcomponents_t;
+	};
+
+	namespace detail {
+
+		/*! Inserts every element of the mpl sequence Items into the mpl set Set */
+		template < typename Set, typename Items >
+		struct insert_all:
+			public boost::mpl::fold< Items, Set, boost::mpl::insert< boost::mpl::_1, boost::mpl::_2 > >
+		{};
+
+		struct add_hand_requirements
+		{
+			template < typename Set, typename Policy >
+			struct apply:
+				public insert_all< Set, typename Policy::req_hand_subcomponents_t >
+			{};
+		};
+
+		struct add_board_requirements
+		{
+			template < typename Set, typename Policy >
+			struct apply:
+				public insert_all< Set, typename Policy::req_board_subcomponents_t >
+			{};
+		};
+	}
+
+	/*!
+	Union of the component requirements of every policy in the mpl sequence PolicyList, for use as the component lists of
+	HandAccess_Copy/HandAccess_Ref and BoardAccess_Default. For example:
+
+		typedef required_components< boost::mpl::vector< BlockerAware_PathGen, HandTypeCountSim_PathTraversal > > components_t;
+		typedef BasicBoardPathState<
+			HandAccess_Copy< components_t::hand_t >,
+			BoardAccess_Default< components_t::board_t >
+			> path_state_t;
+	*/
+	template < typename PolicyList >
+	struct required_components
+	{
+		typedef typename boost::mpl::fold< PolicyList, boost::mpl::set0<>, detail::add_hand_requirements >::type		hand_t;
+		typedef typename boost::mpl::fold< PolicyList, boost::mpl::set0<>, detail::add_board_requirements >::type	board_t;
+	};
+
+}
+}
+
+
+#endif
+
+
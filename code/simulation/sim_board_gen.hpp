@@ -3,6 +3,13 @@
 #ifndef EPW_SIM_BOARD_GEN_H
 #define EPW_SIM_BOARD_GEN_H
 
+#include "poker_core/cardset.hpp"
+#include "gen_util/xoshiro.hpp"
+
+#include <array>
+#include <cassert>
+#include <utility>
+
 
 namespace epw {
 namespace sim {
@@ -19,8 +26,7 @@ namespace sim {
 				Cardset cs;
 				do
 				{
-					boost::random::uniform_int_distribution< size_t > const card_dist(0, FULL_DECK_SIZE - 1);
-					card_index = card_dist(context.gen);
+					card_index = (size_t)rand_below(context.gen, FULL_DECK_SIZE);
 					cs = Cardset::from_card(card_index);
 
 				} while(!path_state.deck.contains_any(cs));
@@ -31,6 +37,35 @@ namespace sim {
 		}
 	};
 
+	/*!
+	Deals from a compact array of the cards remaining in the path's deck, using a partial Fisher-Yates shuffle, so that every draw
+	produces a live card regardless of how many cards are already out.
+	*/
+	class LiveDeckBoardGen
+	{
+	public:
+		template < typename SimContext, typename PathState >
+		static inline void runout_board(size_t const num_cards, SimContext& context, PathState& path_state)
+		{
+			if(num_cards == 0)
+			{
+				return;
+			}
+
+			std::array< Card, FULL_DECK_SIZE > live;
+			size_t const num_live = path_state.deck.get_cards(live.data());
+			assert(num_live >= num_cards);
+
+			for(size_t i = 0; i < num_cards; ++i)
+			{
+				std::swap(live[i], live[i + (size_t)rand_below(context.gen, num_live - i)]);
+
+				path_state.on_board_card(live[i]);
+				path_state.deck.remove(live[i]);
+			}
+		}
+	};
+
 }
 }
 
@@ -3,9 +3,12 @@
 #ifndef EPW_SIM_CONTEXT_H
 #define EPW_SIM_CONTEXT_H
 
+#include "gen_util/xoshiro.hpp"
+
 #include <boost/random/mersenne_twister.hpp>
 
 #include <chrono>
+#include <cstdint>
 
 
 namespace epw {
@@ -19,12 +22,50 @@ namespace sim {
 //		boost::random::mersenne_twister_engine< RandIntType >	gen;
 
 		BasicContext()
+		{}
+
+		/*! stream distinguishes cores which are initialized at (near enough) the same instant, so that they don't share a seed */
+		void initialize(size_t stream = 0)
+		{
+			uint64_t const ticks = static_cast< uint64_t >(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+			gen.seed(static_cast< uint32_t >((ticks ^ (stream * 0x9e3779b97f4a7c15ull)) & 0xffffffff));
+		}
+
+		/*! Clock seeded, the spec is not used */
+		template < typename SimSpec >
+		void initialize(SimSpec const& spec, size_t stream = 0)
 		{
-			gen.seed(static_cast< uint32_t >(std::chrono::high_resolution_clock::now().time_since_epoch().count() & 0xffffffff));
+			initialize(stream);
 		}
+	};
 
-		void initialize()
+	/*!
+	Context with a reproducible random stream. Every core running a simulation seeds its generator with the spec's seed, then core i
+	jumps ahead i * 2^128 draws, so the cores' streams cannot overlap, and a run gives identical results given the same seed and number
+	of cores.
+	*/
+	struct SeededContext
+	{
+		xoshiro256starstar			gen;
+
+		SeededContext()
 		{}
+
+		template < typename SimSpec >
+		void initialize(SimSpec const& spec, size_t stream = 0)
+		{
+			gen.seed(spec.get_seed());
+			for(size_t i = 0; i < stream; ++i)
+			{
+				gen.jump();
+			}
+		}
+
+		/*! A seed for a run where none was specified */
+		static inline uint64_t clock_seed()
+		{
+			return static_cast< uint64_t >(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+		}
 	};
 
 }
@@ -0,0 +1,50 @@
+// sim_handeval_direct.hpp
+
+#ifndef EPW_SIM_HANDEVAL_DIRECT_H
+#define EPW_SIM_HANDEVAL_DIRECT_H
+
+#include "hand_access_components.hpp"
+#include "board_access_components.hpp"
+
+#include "hand_eval/omaha_hand_eval.hpp"
+
+#include <boost/mpl/set.hpp>
+
+
+namespace epw {
+namespace sim {
+
+	/*! Direct lookup evaluation (see OmahaHandEval). The board key is updated once per board card, so that evaluating each player
+	requires only 6 non-flush lookups, plus a flush lookup for each suited pair of hand cards when a flush is possible.
+	Requires LookupTables::OMAHA_EVAL.
+	*/
+	class HandEval_OmahaDirect
+	{
+	public:
+		typedef boost::mpl::set<
+			Hand_Cards
+			> req_hand_subcomponents_t;
+
+		typedef boost::mpl::set<
+			Board_OmahaEvalKey
+			> req_board_subcomponents_t;
+
+	public:
+		template <
+			typename PathState
+		>
+		static inline HandVal evaluate_player_hand(size_t player, PathState const& path_state)
+		{
+			auto const& hand_cards = path_state.get_current_hand_data< Hand_Cards >(player);
+			Board_OmahaEvalKey::data_t const& board = path_state.get_board_data< Board_OmahaEvalKey >();
+
+			return OmahaHandEval::evaluate(hand_cards, board.key);
+		}
+	};
+
+}
+}
+
+
+#endif
+
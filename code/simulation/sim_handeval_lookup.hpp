@@ -10,6 +10,8 @@
 
 #include <boost/mpl/set.hpp>
 
+#include <cassert>
+
 
 namespace epw {
 namespace sim {
@@ -68,6 +70,43 @@ namespace sim {
 		}
 	};
 
+	/*! Board conditioned rank pair lookup. All board related work is done once per board by Board_RankPairTable, leaving a single
+	table lookup for each of a hand's 6 two card combos. Only valid for a complete board.
+	*/
+	class HandEval_BoardRankPairLookup
+	{
+	public:
+		typedef boost::mpl::set<
+			Hand_TwoRankCombos
+			> req_hand_subcomponents_t;
+
+		typedef boost::mpl::set<
+			Board_RankPairTable
+			> req_board_subcomponents_t;
+
+	public:
+		template <
+			typename PathState
+		>
+		static inline HandVal evaluate_player_hand(size_t player, PathState const& path_state)
+		{
+			Hand_TwoRankCombos::data_t const& hand_combos = path_state.get_current_hand_data< Hand_TwoRankCombos >(player);
+			Board_RankPairTable::data_t const& table = path_state.get_board_data< Board_RankPairTable >();
+
+			assert(table.cards.count == MAX_BOARD_CARDS);
+
+			HandVal best = HandVal::NOTHING;
+			for(size_t i = 0; i < 6; ++i)
+			{
+				size_t const idx = hand_combos[i].lex_idx;
+				HandVal const val = hand_combos[i].suit == table.flush_suit ? table.suited[idx] : table.nonflush[idx];
+				best = std::max(best, val);
+			}
+
+			return best;
+		}
+	};
+
 }
 }
 
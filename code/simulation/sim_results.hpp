@@ -3,12 +3,55 @@
 #ifndef EPW_SIM_RESULTS_H
 #define EPW_SIM_RESULTS_H
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 
 
 namespace epw {
 namespace sim {
 
+	/*!
+	The sample mean of a per sample quantity, along with the standard error of that mean, calculated from the sum and sum of squares
+	of the quantity over all samples.
+	*/
+	struct Estimate
+	{
+		double		mean;
+		double		std_err;
+
+		Estimate(): mean(0.0), std_err(0.0)
+		{}
+
+		static inline Estimate from_sums(double const sum, double const sum_sq, size_t const n)
+		{
+			Estimate e;
+			if(n > 0)
+			{
+				e.mean = sum / n;
+			}
+			if(n > 1)
+			{
+				double const variance = std::max((sum_sq - n * e.mean * e.mean) / (n - 1), 0.0);
+				e.std_err = std::sqrt(variance / n);
+			}
+			return e;
+		}
+
+		/*! For the frequency of an event which occurred count times in n samples */
+		static inline Estimate from_count(size_t const count, size_t const n)
+		{
+			return from_sums((double)count, (double)count, n);
+		}
+
+		/*! Half width of the 95% confidence interval of the mean */
+		inline double confidence_95() const
+		{
+			return 1.96 * std_err;
+		}
+	};
+
 	struct SimResultsBase
 	{
 		size_t					num_samples;
@@ -17,8 +60,40 @@ namespace sim {
 		typedef std::chrono::duration< uint64_t, std::milli > duration_t;
 		duration_t dur;
 
-		SimResultsBase(): num_samples(0), dur(0)
+		/*! Largest standard error over all of the simulation's estimates, or zero if not calculated (exhaustive enumeration) */
+		double					max_std_err;
+
+		/*! Seed the run's random streams were derived from */
+		uint64_t				seed;
+
+		/*! Whether every path was visited with its true weight, as by exhaustive enumeration, so that the estimates have no error */
+		bool					exact;
+
+		SimResultsBase(): num_samples(0), dur(0), max_std_err(0.0), seed(0), exact(false)
 		{}
+
+		/*! Accumulates the sample count of another set of results. Duration is wall-clock time of the whole run, so is left to the caller. */
+		inline void combine_with(SimResultsBase const& other)
+		{
+			num_samples += other.num_samples;
+		}
+
+		/*! Estimate from the sums of a quantity over n samples, with zero standard error if the results are exact */
+		inline Estimate estimate_from_sums(double const sum, double const sum_sq, size_t const n) const
+		{
+			Estimate e = Estimate::from_sums(sum, sum_sq, n);
+			if(exact)
+			{
+				e.std_err = 0.0;
+			}
+			return e;
+		}
+
+		/*! As estimate_from_sums(), for the frequency of an event which occurred count times in n samples */
+		inline Estimate estimate_from_count(size_t const count, size_t const n) const
+		{
+			return estimate_from_sums((double)count, (double)count, n);
+		}
 	};
 
 }
@@ -0,0 +1,110 @@
+// sim_snapshot.hpp
+
+#ifndef EPW_SIM_SNAPSHOT_H
+#define EPW_SIM_SNAPSHOT_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+namespace epw {
+namespace sim {
+
+	enum {
+		CACHE_LINE_SIZE = 64,
+	};
+
+	/*!
+	Lock free publication of one worker's results while a simulation is running, for reading by a monitoring thread.
+
+	The slot is a triple buffer: the worker writes into its back buffer then swaps it with the middle buffer, and the reader swaps the
+	middle buffer with its front buffer only if something new has been published since. Each side only ever touches the buffer it
+	currently owns, so neither ever waits for the other, and the reader always sees a complete set of results. The epoch counts
+	publications, so the reader can tell whether anything has changed.
+
+	The worker only publishes when the reader has asked it to, so copying the results costs nothing until somebody is watching. There
+	must be at most one reader at a time.
+	*/
+	template < typename Results >
+	class alignas(CACHE_LINE_SIZE) SnapshotSlot
+	{
+	public:
+		typedef Results		results_t;
+
+	public:
+		SnapshotSlot(): m_back(0), m_front(1), m_middle(2), m_epoch(0), m_requested(false)
+		{}
+
+		/*! Sets every buffer to the given results. Must not be called while the worker or reader are using the slot. */
+		void reset(results_t const& res)
+		{
+			m_buffers.fill(res);
+			m_back = 0;
+			m_front = 1;
+			m_middle.store(2, std::memory_order_relaxed);
+			m_epoch.store(0, std::memory_order_relaxed);
+			m_requested.store(false, std::memory_order_relaxed);
+		}
+
+		/*! Worker side. Whether the reader is waiting for fresh results; cheap enough to test between every chunk of samples. */
+		inline bool requested() const
+		{
+			return m_requested.load(std::memory_order_relaxed);
+		}
+
+		/*! Worker side. Results to be published should be written here, then published with publish(). */
+		inline results_t& back_buffer()
+		{
+			return m_buffers[m_back];
+		}
+
+		/*! Worker side. Makes the back buffer visible to the reader. */
+		inline void publish()
+		{
+			m_back = m_middle.exchange(m_back | DIRTY, std::memory_order_acq_rel) & INDEX_MASK;
+			m_epoch.fetch_add(1, std::memory_order_release);
+			m_requested.store(false, std::memory_order_relaxed);
+		}
+
+		/*! Reader side. The most recently published results, and asks the worker to publish again. */
+		inline results_t const& latest()
+		{
+			if(m_middle.load(std::memory_order_relaxed) & DIRTY)
+			{
+				m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+			}
+			m_requested.store(true, std::memory_order_relaxed);
+			return m_buffers[m_front];
+		}
+
+		/*! Number of times results have been published */
+		inline uint64_t epoch() const
+		{
+			return m_epoch.load(std::memory_order_acquire);
+		}
+
+	private:
+		enum : uint32_t {
+			INDEX_MASK = 3,
+			DIRTY = 4,		// Set in m_middle when it holds results the reader has not yet seen
+		};
+
+		std::array< results_t, 3 > m_buffers;
+
+		/*! Owned by the worker and reader respectively */
+		uint32_t m_back;
+		uint32_t m_front;
+
+		/*! Shared, on their own cache line so that the worker's sampling does not contend with a polling reader */
+		alignas(CACHE_LINE_SIZE) std::atomic< uint32_t > m_middle;
+		std::atomic< uint64_t > m_epoch;
+		std::atomic< bool > m_requested;
+	};
+
+}
+}
+
+
+#endif
+
@@ -2,16 +2,23 @@
 
 #include "sim_startup_helpers.hpp"
 #include "simulation_core.hpp"
+#include "parallel_simulation_core.hpp"
+#include "enumeration_core.hpp"
+#include "batched_simulation_core.hpp"
 #include "sim_spec_base.hpp"
 #include "path_state_base.hpp"
 #include "sim_context.hpp"
 #include "basic_path_state.hpp"
 #include "hand_access.hpp"
 #include "board_access.hpp"
-#include "range_tuple_path_gen.hpp"
+#include "required_components.hpp"
+#include "blocker_aware_path_gen.hpp"
 #include "range_count_sim.hpp"
 #include "handtype_count_sim.hpp"
 #include "range_equity_sim.hpp"
+#include "stack_equity_sim.hpp"
+#include "preflop_matchup_store.hpp"
+#include "lookup_tables.hpp"
 
 #include "gen_util/variant_type_access.hpp"
 
@@ -22,9 +29,16 @@
 
 #include <boost/variant/static_visitor.hpp>
 #include <boost/variant/apply_visitor.hpp>
-#include <boost/mpl/set.hpp>
+#include <boost/mpl/vector.hpp>
 #include <boost/function.hpp>
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <vector>
+
 
 namespace epw {
 namespace sim {
@@ -48,19 +62,76 @@ namespace sim {
 
 		bool operator() (HandEquitySimDesc const& desc) const
 		{
-			results = RangeEquitySim_PathTraversal< 2 >::results_t();
-			return run_rangeequity_sim(desc, scenario.initial_state, get_variant_as< RangeEquitySim_PathTraversal< 2 >::results_t >(results));
+			if(desc.breakdown_player)
+			{
+				results = RangeEquitySim_GenericHandBreakdownResults();
+				return run_handbreakdown_sim(desc, scenario.initial_state, get_variant_as< RangeEquitySim_GenericHandBreakdownResults >(results));
+			}
+
+			results = RangeEquitySim_GenericResults();
+			return run_rangeequity_sim(desc, scenario.initial_state, get_variant_as< RangeEquitySim_GenericResults >(results));
 		}
 
 		bool operator() (StackEquitySimDesc const& desc) const
 		{
-			return false;
+			results = StackEquitySim_Results();
+			return run_stackequity_sim(desc, scenario.initial_state, get_variant_as< StackEquitySim_Results >(results));
 		}
 
 		Scenario const& scenario;
 		generic_sim_results_t& results;
 	};
 
+	/*!
+	Determines the lookup tables a sim reads. Every sim reads the Omaha hand tables, and every sim which evaluates hands the direct
+	lookup evaluator tables. The preflop matchup store is only opened for hand equity sims which it could answer.
+	*/
+	struct required_lookup_tables_visitor: public boost::static_visitor< LookupTables::flags_t >
+	{
+		required_lookup_tables_visitor(InitialState const& _initial_state): initial_state(_initial_state)
+		{}
+
+		LookupTables::flags_t operator() (SubrangeCountSimDesc const& desc) const
+		{
+			LookupTables::flags_t flags;
+			flags.set(LookupTables::OMAHA_HANDS);
+			return flags;
+		}
+
+		LookupTables::flags_t operator() (HandTypeCountSimDesc const& desc) const
+		{
+			return evaluating_flags();
+		}
+
+		LookupTables::flags_t operator() (HandEquitySimDesc const& desc) const
+		{
+			LookupTables::flags_t flags = evaluating_flags();
+			if(!desc.breakdown_player &&
+				initial_state.players.size() == 2 &&
+				initial_state.board.count == 0 &&
+				initial_state.dead.empty())
+			{
+				flags.set(LookupTables::PREFLOP_MATCHUPS);
+			}
+			return flags;
+		}
+
+		LookupTables::flags_t operator() (StackEquitySimDesc const& desc) const
+		{
+			return evaluating_flags();
+		}
+
+		static LookupTables::flags_t evaluating_flags()
+		{
+			LookupTables::flags_t flags;
+			flags.set(LookupTables::OMAHA_HANDS);
+			flags.set(LookupTables::OMAHA_EVAL);
+			return flags;
+		}
+
+		InitialState const& initial_state;
+	};
+
 	struct sim_results_output_visitor: public boost::static_visitor< void >
 	{
 		sim_results_output_visitor(sim::InitialState const& _state, sim::SimulationDesc const& _desc): initial_state(_state), sim_desc(_desc)
@@ -80,7 +151,34 @@ namespace sim {
 		string samples_string(SimResultsBase const& results) const
 		{
 			sstream ss;
-			ss << results.num_samples << _T(" samples") << std::endl;
+			ss << results.num_samples << _T(" samples");
+			if(results.exact)
+			{
+				ss << _T(" (exact)");
+			}
+			else if(results.max_std_err > 0.0)
+			{
+				ss << _T(" (max standard error ") << (100.0 * results.max_std_err) << _T("%, 95% confidence intervals shown)");
+			}
+			ss << std::endl;
+			return ss.str();
+		}
+
+		/*! Confidence interval suffix for a percentage, omitted if no standard errors were calculated */
+		string confidence_string(SimResultsBase const& results, Estimate const& est) const
+		{
+			sstream ss;
+			if(results.max_std_err > 0.0)
+			{
+				ss << _T(" +/- ") << (100.0 * est.confidence_95()) << _T("%");
+			}
+			return ss.str();
+		}
+
+		string seed_string(SimResultsBase const& results) const
+		{
+			sstream ss;
+			ss << _T("Seed: ") << results.seed << std::endl;
 			return ss.str();
 		}
 
@@ -141,6 +239,26 @@ namespace sim {
 			return ss.str();
 		}
 
+		string equities_string(RangeEquitySim_GenericResults const& results) const
+		{
+			sstream ss;
+			ss.precision(2);
+			std::fixed(ss);
+
+			ss << _T("Equities:") << std::endl;
+
+			for(size_t p = 0; p < initial_state.players.size(); ++p)
+			{
+				ss << _T("\t") << player_string(p);
+
+				ss << _T(" = ");
+
+				Estimate const eq = results.get_player_equity(p);
+				ss << (100.0 * eq.mean) << _T("%") << confidence_string(results, eq) << std::endl;
+			}
+			return ss.str();
+		}
+
 		void operator() (RangeCountSim_PathTraversal::results_t const& results) const
 		{
 			SubrangeCountSimDesc const& desc = get_variant_as< SubrangeCountSimDesc >(sim_desc);
@@ -151,6 +269,7 @@ namespace sim {
 			cout << sim_title_string();
 			cout << samples_string(results);
 			cout << duration_string(results);
+			cout << seed_string(results);
 			cout << board_string();
 			cout << dead_string();
 
@@ -165,7 +284,8 @@ namespace sim {
 				{
 					for(size_t sr = 0; sr < it->second.size(); ++sr)
 					{
-						cout << _T("\t\t-> ") << it->second[sr].as_string() << _T(" = ") << (100.0 * results[p][sr] / results.num_samples) << _T("%") << std::endl;
+						Estimate const est = results.get_estimate(p, sr);
+						cout << _T("\t\t-> ") << it->second[sr].as_string() << _T(" = ") << (100.0 * est.mean) << _T("%") << confidence_string(results, est) << std::endl;
 					}
 				}
 			}
@@ -181,6 +301,7 @@ namespace sim {
 			cout << sim_title_string();
 			cout << samples_string(results);
 			cout << duration_string(results);
+			cout << seed_string(results);
 			cout << board_string();
 			cout << dead_string();
 
@@ -194,13 +315,14 @@ namespace sim {
 				{
 					if(results[p][ht] > 0)
 					{
-						cout << _T("\t\t-> ") << (HandVal::HandType)ht << _T(" = ") << (100.0 * results[p][ht] / results.num_samples) << _T("%") << std::endl;
+						Estimate const est = results.get_estimate(p, ht);
+						cout << _T("\t\t-> ") << (HandVal::HandType)ht << _T(" = ") << (100.0 * est.mean) << _T("%") << confidence_string(results, est) << std::endl;
 					}
 				}
 			}
 		}
 
-		void operator() (RangeEquitySim_PathTraversal< 2 >::results_t const& results) const
+		void operator() (RangeEquitySim_GenericResults const& results) const
 		{
 			epw::cout.precision(2);
 			std::fixed(epw::cout);
@@ -208,28 +330,78 @@ namespace sim {
 			cout << sim_title_string();
 			cout << samples_string(results);
 			cout << duration_string(results);
+			cout << seed_string(results);
 			cout << board_string();
 			cout << dead_string();
 
-			cout << _T("Equities:") << std::endl;
+			cout << equities_string(results);
+		}
 
-			for(size_t p = 0; p < initial_state.players.size(); ++p)
+		void operator() (StackEquitySim_Results const& results) const
+		{
+			epw::cout.precision(2);
+			std::fixed(epw::cout);
+
+			cout << sim_title_string();
+			cout << samples_string(results);
+			cout << duration_string(results);
+			cout << seed_string(results);
+			cout << board_string();
+			cout << dead_string();
+
+			cout << _T("Stack equities:") << std::endl;
+
+			for(size_t p = 0; p < results.num_players; ++p)
 			{
-				cout << _T("\t") << player_string(p);
+				Estimate const stack = results.get_player_stack(p);
+				Estimate const eq = results.get_player_equity(p);
+				cout << _T("\t") << player_string(p) << _T(" = ") << results.stacks[p] << _T(" -> ") << stack.mean
+					<< _T(" (") << (100.0 * eq.mean) << _T("%") << confidence_string(results, eq) << _T(")") << std::endl;
+			}
+		}
+
+		void operator() (RangeEquitySim_GenericHandBreakdownResults const& results) const
+		{
+			epw::cout.precision(2);
+			std::fixed(epw::cout);
+
+			cout << sim_title_string();
+			cout << samples_string(results);
+			cout << duration_string(results);
+			cout << seed_string(results);
+			cout << board_string();
+			cout << dead_string();
 
-				cout << _T(" = ");
+			cout << equities_string(results);
 
-				double eq = 0.0;
-				for(auto it = results.begin(); it != results.end(); ++it)
+			// Hands in order of decreasing equity
+			std::vector< size_t > order;
+			for(size_t h = 0; h < results.hands.size(); ++h)
+			{
+				if(results.samples[h] > 0)
 				{
-					if(results.get_oc(it).get_player_rank(p) == 0)
-					{
-						eq += (double)results.get_oc_count(it) / results.get_oc(it).get_player_count_at_rank(0);
-					}
+					order.push_back(h);
 				}
-				eq *= 100.0 / results.num_samples;
+			}
+			std::vector< double > equities(results.hands.size());
+			for(size_t const h: order)
+			{
+				equities[h] = results.get_hand_equity(h).mean;
+			}
+			std::stable_sort(order.begin(), order.end(), [&equities](size_t const a, size_t const b)
+			{
+				return equities[a] > equities[b];
+			});
+
+			cout << _T("Hand equities:") << std::endl;
+			cout << _T("\t") << player_string(results.player) << std::endl;
 
-				cout << eq << _T("%") << std::endl;
+			for(size_t const h: order)
+			{
+				Estimate const eq = results.get_hand_equity(h);
+				cout << _T("\t\t-> ") << LookupTables::omaha_hand_mask(results.hands[h]) << _T(" = ") << (100.0 * eq.mean) << _T("%");
+				cout << confidence_string(results, eq);
+				cout << _T(" (") << results.samples[h] << _T(" samples, ") << results.wins[h] << _T(" wins, ") << results.ties[h] << _T(" ties)") << std::endl;
 			}
 		}
 
@@ -238,31 +410,293 @@ namespace sim {
 	};
 
 
+	enum {
+		PROGRESS_INTERVAL_MS = 1000,
+	};
+
+	/*!
+	Monitor for ParallelSimulationCore::run_monitored(), reporting the number of samples done so far on cerr. Nothing is shown for
+	runs which complete within PROGRESS_INTERVAL_MS, and otherwise the one line is overwritten at each report, and ended by finish().
+	Passed with std::ref, so that the same monitor is kept across the successive runs made by run_sim_core_to_target().
+	*/
+	class progress_monitor
+	{
+	public:
+		typedef std::chrono::steady_clock clock_t;
+
+	public:
+		progress_monitor(): m_commenced(clock_t::now()), m_shown(false)
+		{}
+
+		static inline std::chrono::milliseconds interval()
+		{
+			return std::chrono::milliseconds(PROGRESS_INTERVAL_MS);
+		}
+
+		template < typename Results >
+		bool operator() (Results const& results)
+		{
+			// Workers only publish once asked to, so the first snapshot taken has nothing to show
+			if(results.num_samples > 0 && clock_t::now() - m_commenced >= interval())
+			{
+				cerr << _T("\r") << results.num_samples << _T(" samples") << std::flush;
+				m_shown = true;
+			}
+			return true;
+		}
+
+		void finish()
+		{
+			if(m_shown)
+			{
+				cerr << std::endl;
+			}
+		}
+
+	private:
+		clock_t::time_point m_commenced;
+		bool m_shown;
+	};
+
+	/*!
+	Runs num_samples of the given core type over all available hardware threads, storing the merged results. Returns false if the
+	run was cancelled, in which case the results are partial.
+	*/
+	template < typename SimCore >
+	bool run_sim_core(typename SimCore::sim_spec_t const& sim_spec, sample_count_t const num_samples, typename SimCore::results_t& results)
+	{
+		typedef ParallelSimulationCore< SimCore > parallel_core_t;
+
+		// TODO: Where best to place this?
+		std::chrono::system_clock::time_point commenced = std::chrono::system_clock::now();
+
+		parallel_core_t core(sim_spec);
+
+		core.initialize();
+
+		progress_monitor monitor;
+		bool const completed = core.run_monitored(num_samples, progress_monitor::interval(), std::ref(monitor));
+		monitor.finish();
+
+		std::chrono::system_clock::time_point finished = std::chrono::system_clock::now();
+
+		core.get_results(results);
+		results.dur = std::chrono::duration_cast< SimResultsBase::duration_t >(finished - commenced);
+		return completed;
+	}
+
+	/*!
+	Runs the given core type over all available hardware threads until time_limit_ms has passed, or max_samples have been run,
+	storing the merged results. Intended for requests with a fixed latency budget, which want the best estimate obtainable in it.
+	*/
+	template < typename SimCore >
+	void run_sim_core_for_time(
+		typename SimCore::sim_spec_t const& sim_spec,
+		uint32_t const time_limit_ms,
+		sample_count_t const max_samples,
+		typename SimCore::results_t& results
+		)
+	{
+		typedef ParallelSimulationCore< SimCore > parallel_core_t;
+
+		std::chrono::system_clock::time_point commenced = std::chrono::system_clock::now();
+
+		parallel_core_t core(sim_spec);
+
+		core.initialize();
+
+		progress_monitor monitor;
+		core.run_until_monitored(
+			parallel_core_t::clock_t::now() + std::chrono::milliseconds(time_limit_ms),
+			max_samples,
+			progress_monitor::interval(),
+			std::ref(monitor)
+			);
+		monitor.finish();
+
+		std::chrono::system_clock::time_point finished = std::chrono::system_clock::now();
+
+		core.get_results(results);
+		results.dur = std::chrono::duration_cast< SimResultsBase::duration_t >(finished - commenced);
+	}
+
+	enum {
+		CONVERGENCE_MIN_BATCH_SAMPLES = 10000,
+
+		// Full enumerations which may visit more paths than this are run as Monte Carlo simulations instead
+		MAX_ENUMERATED_PATHS = 2000000000,
+	};
+
+	/*!
+	Runs the given core type in batches until the largest standard error of the results' estimates is no greater than target_std_err,
+	or until max_samples or the time limit (if nonzero) is reached. Batch sizes are chosen from the standard error falling as
+	1 / sqrt(n), at most doubling the samples done so far each time so that a poor early estimate does not overshoot by much.
+	*/
+	template < typename SimCore >
+	void run_sim_core_to_target(
+		typename SimCore::sim_spec_t const& sim_spec,
+		double const target_std_err,
+		sample_count_t const max_samples,
+		uint32_t const time_limit_ms,
+		typename SimCore::results_t& results
+		)
+	{
+		typedef ParallelSimulationCore< SimCore > parallel_core_t;
+
+		std::chrono::system_clock::time_point commenced = std::chrono::system_clock::now();
+		typename parallel_core_t::clock_t::time_point const deadline = time_limit_ms > 0 ?
+			parallel_core_t::clock_t::now() + std::chrono::milliseconds(time_limit_ms) :
+			parallel_core_t::clock_t::time_point::max();
+
+		parallel_core_t core(sim_spec);
+
+		core.initialize();
+
+		progress_monitor monitor;
+		sample_count_t done = 0;
+		sample_count_t batch = std::min< sample_count_t >(CONVERGENCE_MIN_BATCH_SAMPLES, max_samples);
+		while(batch > 0)
+		{
+			// Batches are cut short at the deadline, so done may be an overestimate after the last, but is then no longer needed
+			core.run_until_monitored(deadline, batch, progress_monitor::interval(), std::ref(monitor));
+			done += batch;
+
+			core.get_results(results);
+			double const std_err = results.get_max_std_err();
+			if(std_err <= target_std_err || parallel_core_t::clock_t::now() >= deadline)
+			{
+				break;
+			}
+
+			double const ratio = std_err / target_std_err;
+			sample_count_t const needed = (sample_count_t)(done * ratio * ratio);
+			batch = needed > done ? needed - done : 0;
+			batch = std::max< sample_count_t >(batch, CONVERGENCE_MIN_BATCH_SAMPLES);
+			batch = std::min(batch, done);
+			batch = std::min(batch, max_samples - done);
+		}
+		monitor.finish();
+
+		std::chrono::system_clock::time_point finished = std::chrono::system_clock::now();
+
+		results.dur = std::chrono::duration_cast< SimResultsBase::duration_t >(finished - commenced);
+	}
+
+	/*!
+	Runs a Monte Carlo simulation, for either a fixed number of samples, to the target standard error, or for the time given by the
+	desc. A time limit without a sample count lifts the sample cap, so that the run takes all of the time available, and a target
+	without either has a cap of DEFAULT_TARGET_MAX_SAMPLES, well beyond what any reasonable target needs.
+	*/
+	template < typename SimCore >
+	void run_monte_carlo_sim(typename SimCore::sim_spec_t const& sim_spec, SimulationDescBase const& desc, typename SimCore::results_t& results)
+	{
+		sample_count_t const max_samples = desc.num_samples ? *desc.num_samples :
+			desc.time_limit_ms > 0 ? std::numeric_limits< sample_count_t >::max() :
+			desc.target_std_err > 0.0 ? (sample_count_t)SimulationDescBase::DEFAULT_TARGET_MAX_SAMPLES :
+			desc.get_num_samples();
+
+		if(desc.target_std_err > 0.0)
+		{
+			run_sim_core_to_target< SimCore >(sim_spec, desc.target_std_err, max_samples, desc.time_limit_ms, results);
+		}
+		else if(desc.time_limit_ms > 0)
+		{
+			run_sim_core_for_time< SimCore >(sim_spec, desc.time_limit_ms, max_samples, results);
+		}
+		else
+		{
+			run_sim_core< SimCore >(sim_spec, desc.get_num_samples(), results);
+		}
+
+		results.max_std_err = results.get_max_std_err();
+	}
+
+
+	/*!
+	Runs a simulation which deals out the board, using either MonteCarloCore or EnumerationCore according to the requested
+	enumeration mode. When enumerating runouts only, enough hand tuples are generated to give approximately num_samples paths.
+	A full enumeration which could visit more than MAX_ENUMERATED_PATHS paths falls back to Monte Carlo, with inexact results.
+	A target standard error applies to Monte Carlo runs only, and descs combining one with enumeration are rejected when parsed.
+	*/
+	template <
+		typename SimSpec,
+		typename SimContext,
+		typename PathState,
+		typename PathGen,
+		typename PathTraversal,
+		typename MonteCarloCore
+	>
+	void run_board_sim(SimSpec const& sim_spec, BoardSimulationDescBase const& desc, typename PathTraversal::results_t& results)
+	{
+		assert(desc.is_valid());
+
+		sample_count_t const num_samples = desc.get_num_samples();
+		switch(desc.enumeration)
+		{
+		case ENUMERATE_RUNOUTS:
+			{
+				typedef EnumerationCore< SimSpec, SimContext, PathState, PathGen, PathTraversal, false > sim_core_t;
+				run_sim_core< sim_core_t >(sim_spec, sim_core_t::tuples_for_samples(sim_spec, num_samples), results);
+			}
+			break;
+
+		case ENUMERATE_ALL:
+			{
+				typedef EnumerationCore< SimSpec, SimContext, PathState, PathGen, PathTraversal, true > sim_core_t;
+				if(sim_core_t::enumerated_paths_bound(sim_spec) > MAX_ENUMERATED_PATHS)
+				{
+					run_monte_carlo_sim< MonteCarloCore >(sim_spec, desc, results);
+					break;
+				}
+
+				results.exact = run_sim_core< sim_core_t >(sim_spec, 0, results);
+			}
+			break;
+
+		default:
+			{
+				run_monte_carlo_sim< MonteCarloCore >(sim_spec, desc, results);
+			}
+			break;
+		}
+	}
+
+
 	bool run_simulation(Scenario const& scenario, size_t const sim_idx, generic_sim_results_t& results)
 	{
 		return boost::apply_visitor(run_sim_visitor(scenario, results), scenario.sims[sim_idx]);
 	}
 
+	LookupTables::flags_t required_lookup_tables(Scenario const& scenario, size_t const sim_idx)
+	{
+		return boost::apply_visitor(required_lookup_tables_visitor(scenario.initial_state), scenario.sims[sim_idx]);
+	}
+
 	bool run_subrangecount_sim(SubrangeCountSimDesc const& desc, InitialState const& initial_state, RangeCountSim_PathTraversal::results_t& results)
 	{
-		typedef boost::mpl::set< Hand_LexIndex > hand_subcomponents_t;
+		typedef RangeCountSim_Spec sim_spec_t;
 
-		typedef HandAccess_Copy<
-			hand_subcomponents_t
-		> hand_access_t;
+		typedef required_components< boost::mpl::vector<
+			BlockerAware_PathGen,
+			RangeCountSim_PathTraversal
+			> > components_t;
 
-		typedef RangeCountSim_Spec sim_spec_t;
+		typedef HandAccess_Ref<
+			components_t::hand_t,
+			sim_spec_t
+		> hand_access_t;
 
 		typedef SimulationCore<
 			sim_spec_t,
-			BasicContext,
+			SeededContext,
 			BasicPathState< hand_access_t >,
-			RangeTuple_PathGen,
+			BlockerAware_PathGen,
 			RangeCountSim_PathTraversal
 		> sim_core_t;
 
 		sim_spec_t sim_spec;
 
+		sim_spec.m_seed = desc.seed ? *desc.seed : SeededContext::clock_seed();
 		sim_spec.m_initially_blocked.insert(initial_state.board.begin(), initial_state.board.end());
 		sim_spec.m_initially_blocked |= initial_state.dead;
 		
@@ -283,70 +717,60 @@ namespace sim {
 			sim_spec.m_ranges.push_back(player_range);
 		}
 
-		sim_spec.m_subranges.resize(sim_spec.m_ranges.size());
+		sim_spec.localize_hand_data< components_t::hand_t >();
+
 		for(auto const& sr_info: desc.player_subranges)
 		{
-			RangeCountSim_Spec::player_subranges_t player_subranges;
+			std::vector< RangeCountSim_Spec::lex_subrange_t > player_subranges;
 			
 			for(cmatch::CardMatch const& _cm_sr: sr_info.second)
 			{
 				cmatch::CardMatch cm_sr(_cm_sr);	// TODO: remove this crap when make CardMatch methods const
 
-				boost::dynamic_bitset<> dyn_bs;
-				cm_sr.to_bitset(dyn_bs);
-				assert(dyn_bs.size() == (combinations::ct< FULL_DECK_SIZE, 4 >::res));
-
-				string bs_as_str;
-				boost::to_string(dyn_bs, bs_as_str);
-				player_subranges.push_back(std::bitset< combinations::ct< FULL_DECK_SIZE, 4 >::res >(bs_as_str));
+				player_subranges.push_back(RangeCountSim_Spec::lex_subrange_t());
+				cm_sr.to_bitset(player_subranges.back());
 			}
 
 			size_t player_idx = sr_info.first;
-			sim_spec.m_subranges[player_idx] = player_subranges;
+			sim_spec.set_subranges(player_idx, player_subranges);
 		}
 
-		// TODO: Where best to place this?
-		std::chrono::system_clock::time_point commenced = std::chrono::system_clock::now();
-
-		sim_core_t core(sim_spec);
-
-		core.initialize();
-
-		core.run(desc.num_samples);
-
-		std::chrono::system_clock::time_point finished = std::chrono::system_clock::now();
-
-		core.get_results(results);
-		results.dur = std::chrono::duration_cast< SimResultsBase::duration_t >(finished - commenced);
+		run_monte_carlo_sim< sim_core_t >(sim_spec, desc, results);
+		results.seed = sim_spec.m_seed;
 		return true;
 	}
 
 	bool run_handtypecount_sim(HandTypeCountSimDesc const& desc, InitialState const& initial_state, HandTypeCountSim_PathTraversal::results_t& results)
 	{
-		typedef boost::mpl::set< Hand_LexIndex, Hand_Cards > hand_subcomponents_t;
-		typedef boost::mpl::set< Board_Cards, Board_Mask	// TODO: Only added board mask here cos of hard coded use in BoardAccess_Default constructor, need to just sort that issue...
-			> board_subcomponents_t;
+		typedef HandTypeCountSim_Spec sim_spec_t;
+
+		typedef required_components< boost::mpl::vector<
+			BlockerAware_PathGen,
+			HandTypeCountSim_PathTraversal
+			> > components_t;
 
-		typedef HandAccess_Copy<
-			hand_subcomponents_t
+		typedef HandAccess_Ref<
+			components_t::hand_t,
+			sim_spec_t
 		> hand_access_t;
 
 		typedef BoardAccess_Default<
-			board_subcomponents_t
+			components_t::board_t
 		> board_access_t;
 
-		typedef HandTypeCountSim_Spec sim_spec_t;
+		typedef BasicBoardPathState< hand_access_t, board_access_t > path_state_t;
 
 		typedef SimulationCore<
 			sim_spec_t,
-			BasicContext,
-			BasicBoardPathState< hand_access_t, board_access_t >,
-			RangeTuple_PathGen,
+			SeededContext,
+			path_state_t,
+			BlockerAware_PathGen,
 			HandTypeCountSim_PathTraversal
-		> sim_core_t;
+		> mc_core_t;
 
 		sim_spec_t sim_spec;
 
+		sim_spec.m_seed = desc.seed ? *desc.seed : SeededContext::clock_seed();
 		sim_spec.m_initially_blocked.insert(initial_state.board.begin(), initial_state.board.end());
 		sim_spec.m_initially_blocked |= initial_state.dead;
 		sim_spec.m_initial_board = initial_state.board;
@@ -370,49 +794,19 @@ namespace sim {
 			sim_spec.m_ranges.push_back(player_range);
 		}
 
-		// TODO: Where best to place this?
-		std::chrono::system_clock::time_point commenced = std::chrono::system_clock::now();
-
-		sim_core_t core(sim_spec);
+		sim_spec.localize_hand_data< components_t::hand_t >();
 
-		core.initialize();
-
-		core.run(desc.num_samples);
-
-		std::chrono::system_clock::time_point finished = std::chrono::system_clock::now();
-
-		core.get_results(results);
-		results.dur = std::chrono::duration_cast< SimResultsBase::duration_t >(finished - commenced);
+		run_board_sim< sim_spec_t, SeededContext, path_state_t, BlockerAware_PathGen, HandTypeCountSim_PathTraversal, mc_core_t >(
+			sim_spec, desc, results);
+		results.seed = sim_spec.m_seed;
 		return true;
 	}
 
-	bool run_rangeequity_sim(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_PathTraversal< 2 >::results_t& results)
+	/*! Fills in the spec common to all range equity sims, localizing the hand components in the mpl set HandCompList */
+	template < typename HandCompList >
+	void init_rangeequity_spec(SimulationDescBase const& desc, InitialState const& initial_state, RangeEquitySim_Spec& sim_spec)
 	{
-		typedef boost::mpl::set< Hand_LexIndex, Hand_Cards, Hand_TwoRankCombos > hand_subcomponents_t;
-		typedef boost::mpl::set< Board_Cards, Board_Mask, Board_ThreeRankCombos
-			// TODO: Only added board mask here cos of hard coded use in BoardAccess_Default constructor, need to just sort that issue...
-			> board_subcomponents_t;
-
-		typedef HandAccess_Copy<
-			hand_subcomponents_t
-		> hand_access_t;
-
-		typedef BoardAccess_Default<
-			board_subcomponents_t
-		> board_access_t;
-
-		typedef RangeEquitySim_Spec sim_spec_t;
-
-		typedef SimulationCore<
-			sim_spec_t,
-			BasicContext,
-			BasicBoardPathState< hand_access_t, board_access_t >,
-			RangeTuple_PathGen,
-			RangeEquitySim_PathTraversal< 2 >
-		> sim_core_t;
-
-		sim_spec_t sim_spec;
-
+		sim_spec.m_seed = desc.seed ? *desc.seed : SeededContext::clock_seed();
 		sim_spec.m_initially_blocked.insert(initial_state.board.begin(), initial_state.board.end());
 		sim_spec.m_initially_blocked |= initial_state.dead;
 		sim_spec.m_initial_board = initial_state.board;
@@ -435,22 +829,298 @@ namespace sim {
 			sim_spec.m_ranges.push_back(player_range);
 		}
 
-		// TODO: Where best to place this?
+		sim_spec.localize_hand_data< HandCompList >();
+	}
+
+	/*! Runs a range equity sim for exactly PlayerCount players, converting the results to generic form */
+	template < size_t PlayerCount >
+	bool run_rangeequity_sim(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_GenericResults& results)
+	{
+		typedef RangeEquitySim_Spec sim_spec_t;
+
+		typedef RangeEquitySim_PathTraversal< PlayerCount > path_traversal_t;
+
+		typedef required_components< boost::mpl::vector<
+			BlockerAware_PathGen,
+			path_traversal_t
+			> > components_t;
+
+		typedef HandAccess_Ref<
+			typename components_t::hand_t,
+			sim_spec_t
+		> hand_access_t;
+
+		typedef BoardAccess_Default<
+			typename components_t::board_t
+		> board_access_t;
+
+		typedef BasicBoardPathState< hand_access_t, board_access_t > path_state_t;
+
+		typedef RangeEquitySim_BatchTraversal< PlayerCount > batch_traversal_t;
+
+		typedef BatchedSimulationCore<
+			sim_spec_t,
+			SeededContext,
+			BlockerAware_PathGen,
+			batch_traversal_t
+		> mc_core_t;
+
+		// Enumeration reads hands through the path state, and Monte Carlo through the batch traversal
+		typedef required_components< boost::mpl::vector<
+			BlockerAware_PathGen,
+			path_traversal_t,
+			batch_traversal_t
+			> > spec_components_t;
+
+		sim_spec_t sim_spec;
+		init_rangeequity_spec< typename spec_components_t::hand_t >(desc, initial_state, sim_spec);
+
+		typename path_traversal_t::results_t fixed_results;
+		run_board_sim< sim_spec_t, SeededContext, path_state_t, BlockerAware_PathGen, path_traversal_t, mc_core_t >(
+			sim_spec, desc, fixed_results);
+		fixed_results.seed = sim_spec.m_seed;
+
+		to_generic_results(fixed_results, results);
+		return true;
+	}
+
+	/*!
+	Answers a heads up preflop range equity sim exactly from the global PreflopMatchupStore, with every compatible pair of hands given
+	equal weight as under exhaustive enumeration. Returns false, leaving results untouched, if the store is not open, the sim is not
+	between two small enough ranges with no board or dead cards, or any of the matchups needed is not in the store.
+
+	The results are marked exact. Since they are the same as enumerate=all would give, they are used whatever the sim's enumerate=,
+	target_err=, samples= and time= parameters, none of which could improve on them. num_samples counts the runouts of every
+	matchup, each runout standing for one path of an exhaustive enumeration.
+	*/
+	bool run_rangeequity_from_store(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_GenericResults& results)
+	{
+		PreflopMatchupStore const& store = PreflopMatchupStore::global();
+		if(!store.is_open() ||
+			initial_state.players.size() != 2 ||
+			initial_state.board.count != 0 ||
+			!initial_state.dead.empty() ||
+			initial_state.players[0].range.count() > PreflopMatchupStore::MAX_RANGE_HANDS ||
+			initial_state.players[1].range.count() > PreflopMatchupStore::MAX_RANGE_HANDS)
+		{
+			return false;
+		}
+
 		std::chrono::system_clock::time_point commenced = std::chrono::system_clock::now();
 
-		sim_core_t core(sim_spec);
+		std::array< MultipleRange_SimSpec::lex_range_t, 2 > ranges;
+		cvt_range_bitset_to_list(initial_state.players[0].range, ranges[0]);
+		cvt_range_bitset_to_list(initial_state.players[1].range, ranges[1]);
 
-		core.initialize();
+		typedef RangeEquitySim_Results< showdown_outcome< 2 > > fixed_results_t;
+		fixed_results_t fixed_results;
+		fixed_results.num_players = 2;
+
+		auto const no_hand_index = [](size_t p) { return 0; };
+		for(size_t const lex_1: ranges[0])
+		{
+			Cardset const& h1 = LookupTables::omaha_hand_mask(lex_1);
+			for(size_t const lex_2: ranges[1])
+			{
+				Cardset const& h2 = LookupTables::omaha_hand_mask(lex_2);
+				if(h1.contains_any(h2))
+				{
+					continue;
+				}
+
+				PreflopMatchupStore::Matchup m;
+				if(!store.lookup(h1, h2, m))
+				{
+					return false;
+				}
 
-		core.run(desc.num_samples);
+				fixed_results.record(1 << 0, no_hand_index, m.wins);
+				fixed_results.record(1 << 1, no_hand_index, m.losses());
+				fixed_results.record((1 << 0) | (1 << 1), no_hand_index, m.ties);
+			}
+		}
+
+		if(fixed_results.num_samples == 0)
+		{
+			return false;
+		}
 
 		std::chrono::system_clock::time_point finished = std::chrono::system_clock::now();
 
-		core.get_results(results);
-		results.dur = std::chrono::duration_cast< SimResultsBase::duration_t >(finished - commenced);
+		fixed_results.dur = std::chrono::duration_cast< SimResultsBase::duration_t >(finished - commenced);
+		fixed_results.seed = desc.seed ? *desc.seed : 0;
+		fixed_results.exact = true;
+
+		to_generic_results(fixed_results, results);
+		return true;
+	}
+
+	bool run_rangeequity_sim(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_GenericResults& results)
+	{
+		// Heads up preflop spots between small ranges are answered exactly from the matchup store, if available, without sampling
+		if(run_rangeequity_from_store(desc, initial_state, results))
+		{
+			return true;
+		}
+
+		// Dispatch to a traversal specialized for the actual number of players
+		switch(initial_state.players.size())
+		{
+		case 2:		return run_rangeequity_sim< 2 >(desc, initial_state, results);
+		case 3:		return run_rangeequity_sim< 3 >(desc, initial_state, results);
+		case 4:		return run_rangeequity_sim< 4 >(desc, initial_state, results);
+		case 5:		return run_rangeequity_sim< 5 >(desc, initial_state, results);
+		case 6:		return run_rangeequity_sim< 6 >(desc, initial_state, results);
+		case 7:		return run_rangeequity_sim< 7 >(desc, initial_state, results);
+		case 8:		return run_rangeequity_sim< 8 >(desc, initial_state, results);
+		case 9:		return run_rangeequity_sim< 9 >(desc, initial_state, results);
+		case 10:	return run_rangeequity_sim< 10 >(desc, initial_state, results);
+
+		default:
+			return false;
+		}
+	}
+
+	/*!
+	Runs a range equity sim for exactly PlayerCount players, with the breakdown player's equity broken down by hand. Paths are
+	evaluated directly from the position of each player's hand in their range, so no hand or board components are copied.
+	*/
+	template < size_t PlayerCount >
+	bool run_handbreakdown_sim(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_GenericHandBreakdownResults& results)
+	{
+		typedef RangeEquitySim_Spec sim_spec_t;
+
+		typedef RangeEquitySim_HandBreakdownResults< showdown_outcome< PlayerCount > > fixed_results_t;
+		typedef RangeEquitySim_BatchTraversal< PlayerCount, fixed_results_t > traversal_t;
+
+		typedef BatchedSimulationCore<
+			sim_spec_t,
+			SeededContext,
+			BlockerAware_PathGen,
+			traversal_t
+		> mc_core_t;
+
+		typedef required_components< boost::mpl::vector<
+			BlockerAware_PathGen,
+			traversal_t
+			> > components_t;
+
+		sim_spec_t sim_spec;
+		init_rangeequity_spec< typename components_t::hand_t >(desc, initial_state, sim_spec);
+		sim_spec.m_breakdown_player = *desc.breakdown_player;
+
+		fixed_results_t fixed_results;
+		run_board_sim< sim_spec_t, SeededContext, BatchPathState, BlockerAware_PathGen, traversal_t, mc_core_t >(
+			sim_spec, desc, fixed_results);
+		fixed_results.seed = sim_spec.m_seed;
+
+		to_generic_results(fixed_results, results);
+		return true;
+	}
+
+	bool run_handbreakdown_sim(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_GenericHandBreakdownResults& results)
+	{
+		if(!desc.breakdown_player || *desc.breakdown_player >= initial_state.players.size())
+		{
+			return false;
+		}
+
+		switch(initial_state.players.size())
+		{
+		case 2:		return run_handbreakdown_sim< 2 >(desc, initial_state, results);
+		case 3:		return run_handbreakdown_sim< 3 >(desc, initial_state, results);
+		case 4:		return run_handbreakdown_sim< 4 >(desc, initial_state, results);
+		case 5:		return run_handbreakdown_sim< 5 >(desc, initial_state, results);
+		case 6:		return run_handbreakdown_sim< 6 >(desc, initial_state, results);
+		case 7:		return run_handbreakdown_sim< 7 >(desc, initial_state, results);
+		case 8:		return run_handbreakdown_sim< 8 >(desc, initial_state, results);
+		case 9:		return run_handbreakdown_sim< 9 >(desc, initial_state, results);
+		case 10:	return run_handbreakdown_sim< 10 >(desc, initial_state, results);
+
+		default:
+			return false;
+		}
+	}
+
+
+	/*! Runs a stack equity sim for exactly PlayerCount players */
+	template < size_t PlayerCount >
+	bool run_stackequity_sim(StackEquitySimDesc const& desc, StackEquitySim_Spec const& sim_spec, StackEquitySim_Results& results)
+	{
+		typedef StackEquitySim_Spec sim_spec_t;
+		typedef StackEquitySim_BatchTraversal< PlayerCount > traversal_t;
+
+		typedef BatchedSimulationCore<
+			sim_spec_t,
+			SeededContext,
+			BlockerAware_PathGen,
+			traversal_t
+		> mc_core_t;
+
+		run_board_sim< sim_spec_t, SeededContext, BatchPathState, BlockerAware_PathGen, traversal_t, mc_core_t >(
+			sim_spec, desc, results);
+		results.seed = sim_spec.m_seed;
 		return true;
 	}
 
+	bool run_stackequity_sim(StackEquitySimDesc const& desc, InitialState const& initial_state, StackEquitySim_Results& results)
+	{
+		if(!initial_state.hand_state)
+		{
+			return false;
+		}
+
+		// Players with no stack given cover everyone else
+		std::vector< boost::optional< double > > const& given = initial_state.hand_state->stacks;
+		double max_stack = 0.0;
+		for(boost::optional< double > const& s: given)
+		{
+			if(s)
+			{
+				max_stack = std::max(max_stack, *s);
+			}
+		}
+		if(max_stack <= 0.0)
+		{
+			return false;
+		}
+
+		std::vector< double > stacks(initial_state.players.size(), max_stack);
+		for(size_t p = 0; p < std::min(given.size(), stacks.size()); ++p)
+		{
+			if(given[p])
+			{
+				stacks[p] = *given[p];
+			}
+		}
+
+		// The hand components needed do not depend on the number of players
+		typedef required_components< boost::mpl::vector<
+			BlockerAware_PathGen,
+			StackEquitySim_BatchTraversal< 2 >
+			> > components_t;
+
+		StackEquitySim_Spec sim_spec;
+		init_rangeequity_spec< components_t::hand_t >(desc, initial_state, sim_spec);
+		sim_spec.initialize_payouts(stacks);
+
+		switch(initial_state.players.size())
+		{
+		case 2:		return run_stackequity_sim< 2 >(desc, sim_spec, results);
+		case 3:		return run_stackequity_sim< 3 >(desc, sim_spec, results);
+		case 4:		return run_stackequity_sim< 4 >(desc, sim_spec, results);
+		case 5:		return run_stackequity_sim< 5 >(desc, sim_spec, results);
+		case 6:		return run_stackequity_sim< 6 >(desc, sim_spec, results);
+		case 7:		return run_stackequity_sim< 7 >(desc, sim_spec, results);
+		case 8:		return run_stackequity_sim< 8 >(desc, sim_spec, results);
+		case 9:		return run_stackequity_sim< 9 >(desc, sim_spec, results);
+		case 10:	return run_stackequity_sim< 10 >(desc, sim_spec, results);
+
+		default:
+			return false;
+		}
+	}
+
 
 	void output_sim_results(Scenario const& scenario, size_t const sim_idx, generic_sim_results_t const& results)
 	{
@@ -7,6 +7,8 @@
 #include "range_count_sim.hpp"
 #include "handtype_count_sim.hpp"
 #include "range_equity_sim.hpp"
+#include "stack_equity_sim.hpp"
+#include "lookup_tables.hpp"
 
 
 namespace epw {
@@ -15,14 +17,21 @@ namespace sim {
 	typedef boost::variant<
 		RangeCountSim_PathTraversal::results_t,
 		HandTypeCountSim_PathTraversal::results_t,
-		RangeEquitySim_PathTraversal< 2 >::results_t
+		RangeEquitySim_GenericResults,
+		RangeEquitySim_GenericHandBreakdownResults,
+		StackEquitySim_Results
 	> generic_sim_results_t;
 
 	bool run_simulation(Scenario const& scenario, size_t sim_idx, generic_sim_results_t& results);
 
+	/*! The lookup tables which must be initialized before running the given sim */
+	LookupTables::flags_t required_lookup_tables(Scenario const& scenario, size_t sim_idx);
+
 	bool run_subrangecount_sim(SubrangeCountSimDesc const& desc, InitialState const& initial_state, RangeCountSim_PathTraversal::results_t& results);
 	bool run_handtypecount_sim(HandTypeCountSimDesc const& desc, InitialState const& initial_state, HandTypeCountSim_PathTraversal::results_t& results);
-	bool run_rangeequity_sim(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_PathTraversal< 2 >::results_t& results);
+	bool run_rangeequity_sim(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_GenericResults& results);
+	bool run_handbreakdown_sim(HandEquitySimDesc const& desc, InitialState const& initial_state, RangeEquitySim_GenericHandBreakdownResults& results);
+	bool run_stackequity_sim(StackEquitySimDesc const& desc, InitialState const& initial_state, StackEquitySim_Results& results);
 
 	void output_sim_results(Scenario const& scenario, size_t const sim_idx, generic_sim_results_t const& results);
 
@@ -27,8 +27,10 @@ namespace sim {
 	>
 	class SimulationCore
 	{
-	private:
+	public:
 		typedef SimSpec									sim_spec_t;
+
+	private:
 		typedef SimContext								sim_context_t;
 		typedef PathState								path_state_t;
 		typedef PathGen									path_gen_t;
@@ -37,14 +39,19 @@ namespace sim {
 	public:
 		typedef typename path_traversal_t::results_t	results_t;
 
+		enum {
+			INCREMENTAL = true,		// Each call to run() adds further samples to the results
+			PARTITIONED = false,	// Every core runs the same simulation independently
+		};
+
 	public:
 		SimulationCore(sim_spec_t const& _sim_spec): m_sim_spec(_sim_spec)
 		{}
 
-		/*! One-time core initialization */
-		void initialize()
+		/*! One-time core initialization. core_index identifies this core amongst those running the same simulation. */
+		void initialize(size_t core_index = 0)
 		{
-			m_context.initialize();
+			m_context.initialize(m_sim_spec, core_index);
 			m_path_generator.initialize(m_sim_spec);
 			m_path_traverser.initialize(m_sim_spec);
 		}
@@ -26,12 +26,65 @@ namespace sim {
 	struct SimulationDescBase
 	{
 		boost::optional< string >	name;
-		uint32_t					num_samples;
 
-		enum { DEFAULT_NUM_SAMPLES = 10000 };
+		/*!
+		Fixed sample count, or the sample cap when running to a target standard error or time limit. If not given, a run to a time
+		limit has no cap, a run to a target standard error alone is capped at DEFAULT_TARGET_MAX_SAMPLES, and any other run uses
+		DEFAULT_NUM_SAMPLES.
+		*/
+		boost::optional< uint32_t >	num_samples;
+
+		/*!
+		If nonzero, the simulation is run in batches until the standard error of every estimate it makes (equities or frequencies,
+		as a fraction) is no greater than this, or until num_samples or time_limit_ms is reached. Monte Carlo runs only.
+		*/
+		double						target_std_err;
+
+		/*!
+		If nonzero, a Monte Carlo simulation stops once this much time has passed, reporting whatever estimate it has reached by then.
+		Enumerations ignore it.
+		*/
+		uint32_t					time_limit_ms;
+
+		/*! Seed for the random streams, for reproducing a run. If not given, one is taken from the clock. */
+		boost::optional< uint64_t >	seed;
+
+		enum {
+			DEFAULT_NUM_SAMPLES = 10000,
+			DEFAULT_TARGET_MAX_SAMPLES = 100000000,
+		};
+
+		SimulationDescBase(): target_std_err(0.0), time_limit_ms(0)
+		{}
+
+		/*! Number of samples for a run with neither a target standard error nor a time limit */
+		inline uint32_t get_num_samples() const
+		{
+			return num_samples ? *num_samples : (uint32_t)DEFAULT_NUM_SAMPLES;
+		}
+	};
+
+	/*! How board runouts, and optionally hand tuples, are chosen for simulations which deal out the board */
+	enum EnumerationMode {
+		NO_ENUMERATION,			// Monte Carlo, random hand tuple and runout per sample
+		ENUMERATE_RUNOUTS,		// Random hand tuples, every runout visited for each
+		ENUMERATE_ALL,			// Every compatible hand tuple and every runout visited once, exact result (Monte Carlo if too large)
+	};
+
+	struct BoardSimulationDescBase: public SimulationDescBase
+	{
+		EnumerationMode				enumeration;
+
+		static const EnumerationMode DEFAULT_ENUMERATION = NO_ENUMERATION;
 
-		SimulationDescBase(): num_samples(DEFAULT_NUM_SAMPLES)
+		BoardSimulationDescBase(): enumeration(DEFAULT_ENUMERATION)
 		{}
+
+		/*! Enumerations visit a fixed set of paths, so cannot be run to a target standard error */
+		inline bool is_valid() const
+		{
+			return enumeration == NO_ENUMERATION || target_std_err == 0.0;
+		}
 	};
 
 	struct SubrangeCountSimDesc: public SimulationDescBase
@@ -48,7 +101,7 @@ namespace sim {
 		std::map< size_t, std::vector< cmatch::CardMatch > > player_subranges;
 	};
 
-	struct HandTypeCountSimDesc: public SimulationDescBase
+	struct HandTypeCountSimDesc: public BoardSimulationDescBase
 	{
 		flopgame::Street	street;
 
@@ -58,12 +111,14 @@ namespace sim {
 		{}
 	};
 
-	struct HandEquitySimDesc: public SimulationDescBase
+	struct HandEquitySimDesc: public BoardSimulationDescBase
 	{
-
+		/*! If given, the equity of every hand in this player's range is reported individually, in addition to the overall equities */
+		boost::optional< size_t >	breakdown_player;
 	};
 
-	struct StackEquitySimDesc: public SimulationDescBase
+	/*! Every player is all in for their stack, with the stacks given by the initial state */
+	struct StackEquitySimDesc: public BoardSimulationDescBase
 	{
 
 	};
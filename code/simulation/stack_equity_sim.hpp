@@ -0,0 +1,261 @@
+// stack_equity_sim.hpp
+
+#ifndef EPW_STACK_EQUITY_SIM_H
+#define EPW_STACK_EQUITY_SIM_H
+
+#include "range_equity_sim.hpp"
+#include "sim_results.hpp"
+#include "batched_simulation_core.hpp"
+
+#include "poker_core/pot_state.hpp"
+#include "hand_eval/poker_hand_value.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <vector>
+
+
+namespace epw {
+namespace sim {
+
+	/*!
+	Spec for a stack equity calc, in which every player is all in for their stack, and the stacks are split into side pots as per
+	flopgame::build_side_pots(). The payout to every player for every possible showdown is calculated once, when the spec is set up.
+
+	Only some of the order of the hands at showdown affects the payouts. Taking the players in decreasing order of stack, so that the
+	players eligible for any pot come first, the best hand amongst any leading group of players is held by the last of them to beat the
+	best hand before them, along with any who tie with it after that. So the payouts are fixed by whether each player's hand is worse
+	than, ties or beats the best before it, and the payout table is indexed by these comparisons as a base 3 number.
+	*/
+	class StackEquitySim_Spec: public RangeEquitySim_Spec
+	{
+	public:
+		enum Comparison {
+			WORSE,
+			TIES,
+			BEATS,
+
+			COMPARISON_COUNT,
+		};
+
+	public:
+		/*! Sets each player's stack and builds the payout table */
+		void initialize_payouts(std::vector< double > const& stacks)
+		{
+			size_t const num_players = stacks.size();
+			assert(num_players > 0);
+
+			m_stacks = stacks;
+
+			m_deep_order.resize(num_players);
+			for(size_t p = 0; p < num_players; ++p)
+			{
+				m_deep_order[p] = p;
+			}
+			std::stable_sort(m_deep_order.begin(), m_deep_order.end(), [&stacks](size_t const a, size_t const b)
+			{
+				return stacks[a] > stacks[b];
+			});
+
+			std::vector< flopgame::SidePot > const pots = flopgame::build_side_pots(stacks);
+
+			// The first player has nothing to compare with
+			size_t num_keys = 1;
+			for(size_t i = 1; i < num_players; ++i)
+			{
+				num_keys *= COMPARISON_COUNT;
+			}
+			m_payouts.assign(num_keys * num_players, 0.0);
+
+			std::vector< Comparison > cmp(num_players);
+			std::vector< size_t > winners;
+			for(size_t key = 0; key < num_keys; ++key)
+			{
+				cmp[0] = BEATS;
+				size_t rem = key;
+				for(size_t i = num_players - 1; i > 0; --i)
+				{
+					cmp[i] = (Comparison)(rem % COMPARISON_COUNT);
+					rem /= COMPARISON_COUNT;
+				}
+
+				double* const payouts = &m_payouts[key * num_players];
+				for(flopgame::SidePot const& pot: pots)
+				{
+					winners.clear();
+					for(size_t i = 0; i < num_players && pot.m_eligible.test(m_deep_order[i]); ++i)
+					{
+						if(cmp[i] == BEATS)
+						{
+							winners.clear();
+							winners.push_back(m_deep_order[i]);
+						}
+						else if(cmp[i] == TIES)
+						{
+							winners.push_back(m_deep_order[i]);
+						}
+					}
+
+					for(size_t const w: winners)
+					{
+						payouts[w] += pot.m_size / winners.size();
+					}
+				}
+			}
+		}
+
+		/*! Index into the payout table of the showdown with each player's hand value stride apart */
+		inline size_t payout_key(HandVal const vals[], size_t const stride) const
+		{
+			size_t const num_players = m_deep_order.size();
+
+			HandVal best = vals[m_deep_order[0] * stride];
+			size_t key = 0;
+			for(size_t i = 1; i < num_players; ++i)
+			{
+				HandVal const val = vals[m_deep_order[i] * stride];
+				key *= COMPARISON_COUNT;
+				if(val > best)
+				{
+					best = val;
+					key += BEATS;
+				}
+				else if(val == best)
+				{
+					key += TIES;
+				}
+			}
+			return key;
+		}
+
+		/*! Every player's payout for the showdown with the given key */
+		inline double const* get_payouts(size_t const key) const
+		{
+			return &m_payouts[key * m_deep_order.size()];
+		}
+
+	public:
+		std::vector< double > m_stacks;
+
+		/*! Players in decreasing order of stack */
+		std::vector< size_t > m_deep_order;
+
+		/*! [key * num players + player] */
+		std::vector< double > m_payouts;
+	};
+
+	/*!
+	Stack equity results, as the sum and sum of squares of each player's final stack over all samples.
+	*/
+	struct StackEquitySim_Results: public SimResultsBase
+	{
+		size_t					num_players;
+		std::vector< double >	stacks;			// Initial stacks
+		double					total;			// Sum of all stacks
+
+		std::vector< double >	sums;
+		std::vector< double >	sums_sq;
+
+		StackEquitySim_Results(): num_players(0), total(0.0)
+		{}
+
+		template < typename SimSpec >
+		void initialize(SimSpec const& spec)
+		{
+			num_players = spec.get_num_players();
+			stacks = spec.m_stacks;
+			total = 0.0;
+			for(double const s: stacks)
+			{
+				total += s;
+			}
+			sums.assign(num_players, 0.0);
+			sums_sq.assign(num_players, 0.0);
+		}
+
+		inline void combine_with(StackEquitySim_Results const& other)
+		{
+			SimResultsBase::combine_with(other);
+			for(size_t p = 0; p < num_players; ++p)
+			{
+				sums[p] += other.sums[p];
+				sums_sq[p] += other.sums_sq[p];
+			}
+		}
+
+		/*! Records weight equivalent samples with the given payouts */
+		inline void record(double const payouts[], uint64_t const weight = 1)
+		{
+			for(size_t p = 0; p < num_players; ++p)
+			{
+				sums[p] += weight * payouts[p];
+				sums_sq[p] += weight * payouts[p] * payouts[p];
+			}
+			num_samples += weight;
+		}
+
+		/*! Expected final stack of a player */
+		inline Estimate get_player_stack(size_t const p) const
+		{
+			return estimate_from_sums(sums[p], sums_sq[p], num_samples);
+		}
+
+		/*! Expected final stack of a player as a fraction of all of the chips in play */
+		inline Estimate get_player_equity(size_t const p) const
+		{
+			return estimate_from_sums(sums[p] / total, sums_sq[p] / (total * total), num_samples);
+		}
+
+		inline double get_max_std_err() const
+		{
+			double max_err = 0.0;
+			for(size_t p = 0; p < num_players; ++p)
+			{
+				max_err = std::max(max_err, get_player_equity(p).std_err);
+			}
+			return max_err;
+		}
+	};
+
+	/*!
+	Batch traversal for stack equity calc. Hand values are evaluated exactly as for range equity, after which each path costs just the
+	calculation of its payout key and the accumulation of the payouts looked up from the spec.
+	*/
+	template <
+		size_t PlayerCount
+	>
+	class StackEquitySim_BatchTraversal: public RangeEquitySim_BatchTraversal< PlayerCount, StackEquitySim_Results >
+	{
+	public:
+		typedef StackEquitySim_Results		results_t;
+
+	public:
+		template < typename SimSpec, typename SimContext >
+		void traverse_batch(SimSpec const& spec, SimContext& context, PathBatch const& batch)
+		{
+			this->evaluate_batch_hands(spec, batch);
+
+			for(size_t k = 0; k < batch.count; ++k)
+			{
+				this->m_outcomes.record(spec.get_payouts(spec.payout_key(&this->m_vals[k], batch.capacity)));
+			}
+		}
+
+		/*! Records the payouts of a single path whose board is already complete, standing for weight equivalent paths */
+		template < typename SimSpec, typename SimContext >
+		inline void evaluate_path(SimSpec const& spec, SimContext& context, BatchPathState const& path_state, uint64_t const weight = 1)
+		{
+			std::array< HandVal, PlayerCount > vals;
+			this->evaluate_path_hands(spec, path_state, vals.data());
+
+			this->m_outcomes.record(spec.get_payouts(spec.payout_key(vals.data(), 1)), weight);
+		}
+	};
+
+}
+}
+
+
+#endif
+